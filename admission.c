@@ -0,0 +1,403 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   admission.c
+----------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "wrappers.h"
+#include "shmem.h"
+#include "sales.h"
+#include "admission.h"
+#include "fleet.h"
+
+typedef struct
+{
+    int         id ;
+    int         fd ;            // connection it came in on, -1 once that closed
+    int         size ;
+    int         batch ;         // batch it is made in, 0 while it waits
+    long long   admitted ;      // monotonicNanos() when it was accepted
+} admOrder ;
+
+typedef struct
+{
+    int         fd ;            // -1 when the slot is free
+    int         len ;
+    char        buf[ ADMIT_LINE_MAX ] ;
+} admClient ;
+
+// accepted orders, oldest first
+static admOrder  orders[ ADMIT_MAX_PENDING ];
+static int       norders = 0;
+
+static admClient clients[ ADMIT_MAX_CLIENTS ];
+
+static volatile sig_atomic_t stopping = 0;
+
+
+static void admitStop( int sig ) {
+    stopping = 1;
+}
+
+
+// sends a one line notice to a client. A client that went away just misses it.
+static void notify( int fd, const char *fmt, ... ) {
+
+    char line[ ADMIT_LINE_MAX ];
+    va_list args;
+
+    if ( fd < 0 ) {
+        return;
+    }
+
+    va_start( args, fmt );
+    int len = vsnprintf( line, sizeof(line), fmt, args );
+    va_end( args );
+
+    if ( len >= (int) sizeof(line) ) {
+        len = sizeof(line) - 1;
+    }
+
+    send( fd, line, len, MSG_NOSIGNAL );
+}
+
+
+// handles one request line from client 'c'. Returns 1 if it asked for a shutdown.
+static int handleLine( admClient *c, char *line, int shutting ) {
+
+    static int next_id = 1;
+    int size;
+
+    if ( strcmp( line, "SHUTDOWN" ) == 0 ) {
+        return 1;
+    }
+
+    if ( sscanf( line, "ORDER %d", &size ) != 1 || size < 1 ) {
+        notify( c -> fd, "REJECTED bad request\n" );
+    } else if ( shutting ) {
+        notify( c -> fd, "REJECTED shutting down\n" );
+    } else if ( norders == ADMIT_MAX_PENDING ) {
+        notify( c -> fd, "REJECTED too many pending orders\n" );
+    } else {
+        admOrder *o = &orders[ norders ++ ];
+
+        o -> id       = next_id ++;
+        o -> fd       = c -> fd;
+        o -> size     = size;
+        o -> batch    = 0;
+        o -> admitted = monotonicNanos();
+
+        notify( c -> fd, "ACCEPTED %d\n", o -> id );
+        printf( "SALES: Order #%d of %d parts accepted\n", o -> id, size );
+    }
+
+    return 0;
+}
+
+
+// closes client 'c'. Its orders still get made, nobody hears about it.
+static void dropClient( admClient *c ) {
+
+    for ( int i = 0; i < norders; i ++ ) {
+        if ( orders[i].fd == c -> fd ) {
+            orders[i].fd = -1;
+        }
+    }
+
+    close( c -> fd );
+    c -> fd  = -1;
+    c -> len = 0;
+}
+
+
+void serveOrders( const char *path, int n, int time_scale ) {
+
+    struct sockaddr_un addr;
+    struct pollfd fds[ ADMIT_MAX_CLIENTS + 2 ];
+
+    // the batch being made, if any. It is done once the supervisor has seen
+    // batch_target parts of the open order reported.
+    int       batch_target = 0;
+    int       batch_id     = 0;
+    int       batch_parts  = 0;
+    long long batch_start  = 0;
+
+    int shutting = 0;
+    int broken   = 0;
+
+
+    for ( int i = 0; i < ADMIT_MAX_CLIENTS; i ++ ) {
+        clients[i].fd  = -1;
+        clients[i].len = 0;
+    }
+
+    int listen_fd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    if ( listen_fd == -1 ) {
+        err_sys( "serveOrders: socket failed" );
+    }
+
+    memset( &addr, 0, sizeof(addr) );
+    addr.sun_family = AF_UNIX;
+    snprintf( addr.sun_path, sizeof(addr.sun_path), "%s", path );
+    unlink( path );
+
+    if ( bind( listen_fd, (struct sockaddr*) &addr, sizeof(addr) ) == -1 ) {
+        err_sys( "serveOrders: bind failed" );
+    }
+    if ( listen( listen_fd, 64 ) == -1 ) {
+        err_sys( "serveOrders: listen failed" );
+    }
+
+    sigactionWrapper( SIGINT,  admitStop );
+    sigactionWrapper( SIGTERM, admitStop );
+    sigactionWrapper( SIGPIPE, SIG_IGN );
+
+    // the order narrates nothing, the daemon logs orders and batches instead
+    quiet = 1;
+
+
+    // Open one empty order on a resident fleet. The supervisor gets the write
+    // end of the pipe for its batch done notices.
+    int done[2];
+    if ( pipe( done ) == -1 ) {
+        err_sys( "serveOrders: pipe failed" );
+    }
+    fcntl( done[0], F_SETFD, FD_CLOEXEC );
+    fcntl( done[1], F_SETFD, FD_CLOEXEC );
+    fcntl( done[0], F_SETFL, O_NONBLOCK );
+
+    orderOpen( n, 0, ORDER_POLICY, time_scale, done[1] );
+    close( done[1] );
+
+    printf( "SALES: Taking orders on '%s' with %d factories\n", path, n );
+    fflush( stdout );
+
+
+    while ( ! stopping ) {
+
+        if ( shutting && batch_target == 0 && norders == 0 ) {
+            break;
+        }
+
+        int timeout = REAP_POLL_MSEC;
+
+        // start a batch once the oldest order has waited long enough for
+        // company, or enough parts are waiting anyway
+        if ( batch_target == 0 && norders > 0 ) {
+
+            int pending = 0;
+            for ( int i = 0; i < norders; i ++ ) {
+                pending += orders[i].size;
+            }
+
+            long long waited = monotonicNanos() - orders[0].admitted;
+
+            if ( waited < BATCH_WINDOW_MSEC * 1000000LL && pending < BATCH_MAX_PARTS && ! shutting ) {
+                int left = (int) ( ( BATCH_WINDOW_MSEC * 1000000LL - waited ) / 1000000LL ) + 1;
+                if ( left < timeout ) {
+                    timeout = left;
+                }
+            } else {
+
+                // take orders oldest first. An order bigger than a batch runs alone.
+                batch_id ++;
+                batch_parts = 0;
+
+                for ( int i = 0; i < norders; i ++ ) {
+                    if ( batch_parts > 0 && batch_parts + orders[i].size > BATCH_MAX_PARTS ) {
+                        break;
+                    }
+                    orders[i].batch = batch_id;
+                    batch_parts += orders[i].size;
+                    notify( orders[i].fd, "STARTED %d %d\n", orders[i].id, batch_id );
+                }
+
+                printf( "SALES: Batch #%d of %d parts started\n", batch_id, batch_parts );
+                fflush( stdout );
+
+                batch_start  = monotonicNanos();
+                batch_target = orderExtend( n, batch_parts );
+            }
+        }
+
+
+        // wait for connections, requests, or the batch to finish
+        int nfds = 0;
+
+        fds[nfds].fd     = listen_fd;
+        fds[nfds].events = POLLIN;
+        nfds ++;
+
+        fds[nfds].fd     = done[0];
+        fds[nfds].events = POLLIN;
+        nfds ++;
+
+        for ( int i = 0; i < ADMIT_MAX_CLIENTS; i ++ ) {
+            fds[nfds].fd     = clients[i].fd;
+            fds[nfds].events = POLLIN;
+            nfds ++;
+        }
+
+        if ( poll( fds, nfds, timeout ) == -1 ) {
+            if ( errno == EINTR ) {
+                continue;
+            }
+            err_sys( "serveOrders: poll failed" );
+        }
+
+
+        // restart factories that died. Without its supervisor, or without
+        // any factories, the fleet cannot finish a batch any more.
+        pid_t pid;
+        int   wstatus;
+
+        while ( ( pid = waitpid( -1, &wstatus, WNOHANG ) ) > 0 ) {
+            orderReap( n, pid, wstatus );
+        }
+
+        if ( supervisor_pid == 0 || factories_running == 0 ) {
+            fprintf( stderr, "SALES: The fleet can no longer make orders\n" );
+            broken = 1;
+            break;
+        }
+
+
+        // the batch is done
+        int reached = 0;
+        int got;
+
+        while ( read( done[0], &got, sizeof(got) ) == sizeof(got) ) {
+            reached = got;
+        }
+
+        if ( batch_target != 0 && reached >= batch_target ) {
+
+            long long now = monotonicNanos();
+            int kept = 0;
+
+            for ( int i = 0; i < norders; i ++ ) {
+                if ( orders[i].batch != batch_id ) {
+                    orders[ kept ++ ] = orders[i];
+                } else {
+                    notify( orders[i].fd, "DONE %d %.1f\n",
+                        orders[i].id, ( now - orders[i].admitted ) / 1e6 );
+                }
+            }
+            norders = kept;
+
+            printf( "SALES: Batch #%d of %d parts done in %.1f milliSecs\n",
+                batch_id, batch_parts, ( now - batch_start ) / 1e6 );
+            fflush( stdout );
+
+            batch_target = 0;
+        }
+
+        // a new connection
+        if ( fds[0].revents & POLLIN ) {
+
+            int fd = accept( listen_fd, NULL, NULL );
+
+            if ( fd != -1 ) {
+                // factories restarted from here must not inherit it
+                fcntl( fd, F_SETFD, FD_CLOEXEC );
+
+                int slot = -1;
+                for ( int i = 0; i < ADMIT_MAX_CLIENTS && slot == -1; i ++ ) {
+                    if ( clients[i].fd == -1 ) {
+                        slot = i;
+                    }
+                }
+
+                if ( slot == -1 ) {
+                    notify( fd, "REJECTED too many connections\n" );
+                    close( fd );
+                } else {
+                    clients[slot].fd  = fd;
+                    clients[slot].len = 0;
+                }
+            }
+        }
+
+        // requests
+        for ( int i = 0; i < ADMIT_MAX_CLIENTS; i ++ ) {
+
+            admClient *c = &clients[i];
+
+            if ( c -> fd == -1 || fds[i + 2].revents == 0 ) {
+                continue;
+            }
+
+            int got = read( c -> fd, c -> buf + c -> len, sizeof(c -> buf) - 1 - c -> len );
+
+            if ( got <= 0 ) {
+                dropClient( c );
+                continue;
+            }
+            c -> len += got;
+            c -> buf[ c -> len ] = '\0';
+
+            // handle every complete line, keep the rest for later
+            char *line = c -> buf;
+            char *end;
+
+            while ( ( end = strchr( line, '\n' ) ) != NULL ) {
+                *end = '\0';
+                shutting |= handleLine( c, line, shutting );
+                line = end + 1;
+            }
+
+            c -> len -= line - c -> buf;
+            memmove( c -> buf, line, c -> len );
+
+            // a line too long for the buffer is garbage
+            if ( c -> len == sizeof(c -> buf) - 1 ) {
+                notify( c -> fd, "REJECTED line too long\n" );
+                c -> len = 0;
+            }
+        }
+
+        fflush( stdout );
+    }
+
+
+    // a batch still being made is called off, its unclaimed parts with it
+    if ( batch_target != 0 ) {
+        for ( int i = 0; i < norders; i ++ ) {
+            if ( orders[i].batch == batch_id ) {
+                notify( orders[i].fd, "FAILED %d\n", orders[i].id );
+            }
+        }
+        printf( "SALES: Batch #%d of %d parts called off\n", batch_id, batch_parts );
+    }
+
+    for ( int i = 0; i < ADMIT_MAX_CLIENTS; i ++ ) {
+        if ( clients[i].fd != -1 ) {
+            close( clients[i].fd );
+        }
+    }
+    close( listen_fd );
+    unlink( path );
+
+    printf( "SALES: No longer taking orders\n" );
+    fflush( stdout );
+
+    // let the fleet finish, and close the order
+    orderWindDown( n, batch_target != 0 || broken );
+    orderClose( n );
+    close( done[0] );
+}
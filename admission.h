@@ -0,0 +1,34 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   admission.h
+----------------------------------------------------*/
+
+// Order admission service, sales -d. Sales stays resident and takes orders
+// over a local Unix socket. The protocol is one line per request or notice:
+//
+//   client -> sales    ORDER <size>
+//                      SHUTDOWN
+//   sales -> client    ACCEPTED <order id>
+//                      REJECTED <reason>
+//                      STARTED <order id> <batch id>
+//                      DONE <order id> <milliseconds since accepted>
+//                      FAILED <order id>
+//
+// Orders that arrive close together are batched. The factories, the supervisor
+// and the IPC between them stay up across batches: each batch is added to the
+// one open order, and the supervisor says when all of it has been reported.
+
+#define ADMIT_MAX_CLIENTS       128     // connections open at once
+#define ADMIT_MAX_PENDING       1024    // orders accepted but not done
+#define ADMIT_LINE_MAX          64
+
+#define BATCH_WINDOW_MSEC       50      // how long the first order of a batch waits for company
+#define BATCH_MAX_PARTS         2000    // a batch is started early once it holds this many parts
+#define REAP_POLL_MSEC          100     // longest wait before looking for dead factories
+
+// Serves orders on the Unix socket 'path' with factories 1..n, whose specs
+// must already be set, until a client sends SHUTDOWN or sales is interrupted.
+void    serveOrders( const char *path, int n, int time_scale ) ;
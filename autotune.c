@@ -0,0 +1,163 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   autotune.c
+----------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "wrappers.h"
+#include "shmem.h"
+#include "sales.h"
+#include "autotune.h"
+
+// claim sizes tried, as a percentage of each factory's capacity
+static const int claim_percents[] = { 100, 75, 50 };
+#define NUM_CLAIM_PERCENTS  ( sizeof(claim_percents) / sizeof(claim_percents[0]) )
+
+static const char *policy_names[] = { "fixed", "guided" };
+#define NUM_POLICIES        2
+
+
+// orders factory specs by parts per millisecond, fastest first
+static int byThroughput( const void *a, const void *b ) {
+
+    const int *x = (const int*) a;
+    const int *y = (const int*) b;
+
+    // x[0]/x[1] < y[0]/y[1], without dividing
+    long long lhs = (long long) x[0] * y[1];
+    long long rhs = (long long) y[0] * x[1];
+
+    return ( lhs < rhs ) - ( lhs > rhs );
+}
+
+
+static int byValue( const void *a, const void *b ) {
+
+    long long x = *(const long long*) a;
+    long long y = *(const long long*) b;
+
+    return ( x > y ) - ( x < y );
+}
+
+
+void autotune( int budget, int size, int time_scale, int repeats ) {
+
+    int       specs[ MAXFACTORIES ][2];
+    long long samples[ repeats ];
+
+    // best configuration for each factory count, index 0 unused.
+    // best_span is the makespan in real time, see below.
+    long long best_span[ MAXFACTORIES + 1 ];
+    long long overhead[ MAXFACTORIES + 1 ];
+    int       best_policy[ MAXFACTORIES + 1 ];
+    int       best_percent[ MAXFACTORIES + 1 ];
+
+
+    // draw the pool of factories to choose from. Using k factories always
+    // means using the k fastest, so every count gets the best mix available.
+    for ( int i = 0; i < budget; i ++ ) {
+        // IMPORTANT: modulus operands are 41 and 701, because the range must be inclusive.
+        specs[i][0] = random() % 41  + 10;
+        specs[i][1] = random() % 701 + 500;
+    }
+    qsort( specs, budget, sizeof(specs[0]), byThroughput );
+
+    printf( "AUTOTUNE: Order of %d parts, up to %d factories, time compressed %dx, %d run(s) each\n",
+        size, budget, time_scale, repeats );
+
+    for ( int i = 1; i < budget + 1; i ++ ) {
+        capacities[i] = specs[i-1][0];
+        durations[i]  = specs[i-1][1];
+        printf( "AUTOTUNE: Factory #%3d Capacity=%4d Duration=%4d\n", i, capacities[i], durations[i] );
+    }
+
+
+    // search. Every run is a real order, with the production time compressed.
+    fflush( stdout );
+    quiet = 1;
+
+    for ( int k = 1; k < budget + 1; k ++ ) {
+
+        best_span[k] = -1;
+
+        // Only production is compressed. Starting the processes and setting
+        // up IPC takes as long as it would in real time, and more so the more
+        // factories there are. An empty order measures that overhead, so it
+        // is not scaled up along with the production time.
+        for ( int r = 0; r < repeats; r ++ ) {
+            samples[r] = runOrder( k, 0, CLAIM_FIXED, time_scale );
+        }
+        qsort( samples, repeats, sizeof(long long), byValue );
+        overhead[k] = samples[ repeats / 2 ];
+
+        for ( int policy = 0; policy < NUM_POLICIES; policy ++ ) {
+            for ( int c = 0; c < (int) NUM_CLAIM_PERCENTS; c ++ ) {
+
+                for ( int i = 1; i < k + 1; i ++ ) {
+                    claim_sizes[i] = capacities[i] * claim_percents[c] / 100;
+                    if ( claim_sizes[i] < 1 ) {
+                        claim_sizes[i] = 1;
+                    }
+                }
+
+                for ( int r = 0; r < repeats; r ++ ) {
+                    samples[r] = runOrder( k, size, policy, time_scale );
+                }
+                qsort( samples, repeats, sizeof(long long), byValue );
+
+                long long production = samples[ repeats / 2 ] - overhead[k];
+                if ( production < 0 ) {
+                    production = 0;
+                }
+                long long span = overhead[k] + production * time_scale;
+
+                if ( best_span[k] < 0 || span < best_span[k] ) {
+                    best_span[k]    = span;
+                    best_policy[k]  = policy;
+                    best_percent[k] = claim_percents[c];
+                }
+            }
+        }
+
+        fprintf( stderr, "AUTOTUNE: %d of %d factory counts done\r", k, budget );
+    }
+
+    quiet = 0;
+    fprintf( stderr, "\n" );
+
+
+    // makespan vs. factory count. A count is on the Pareto curve when it
+    // is faster than every smaller count.
+    int       best_k  = 1;
+    long long frontier = -1;
+
+    printf( "\n****** AUTOTUNE: Makespan vs. Factory Count ******\n" );
+    printf( "Factories  Policy  Claim  Makespan (ms)  Overhead (ms)\n" );
+
+    for ( int k = 1; k < budget + 1; k ++ ) {
+
+        int pareto = ( frontier < 0 || best_span[k] < frontier );
+        if ( pareto ) {
+            frontier = best_span[k];
+        }
+
+        if ( best_span[k] < best_span[best_k] ) {
+            best_k = k;
+        }
+
+        printf( "%9d  %6s  %4d%%  %13.1f  %13.1f %s\n",
+            k, policy_names[ best_policy[k] ], best_percent[k],
+            best_span[k] / 1000000.0, overhead[k] / 1000000.0, pareto ? "*" : "" );
+    }
+
+    printf( "* = on the Pareto curve\n" );
+
+    printf( "\nAUTOTUNE: Best configuration: %d factories, %s claims of %d%% capacity, makespan %.1f ms\n",
+        best_k, policy_names[ best_policy[best_k] ], best_percent[best_k],
+        best_span[best_k] / 1000000.0 );
+}
@@ -0,0 +1,16 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   autotune.h
+----------------------------------------------------*/
+
+// Defaults for sales -t
+#define AUTOTUNE_TIME_SCALE     50      // run 50 times faster than real time
+#define AUTOTUNE_REPEATS        3       // runs per configuration, the median counts
+
+// Searches factory count, claim size and claim policy for the smallest
+// makespan of an order of 'size' parts, using at most 'budget' factories.
+// Prints the best configuration and the makespan vs. factory count curve.
+void    autotune( int budget, int size, int time_scale, int repeats );
@@ -0,0 +1,120 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   bench.c
+----------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "wrappers.h"
+#include "shmem.h"
+#include "sales.h"
+#include "fleet.h"
+#include "bench.h"
+
+#ifndef FIXED_FLEET
+#error "bench.c is only part of the fixed plant build"
+#endif
+
+#define NUM_BUILDS  2
+
+static const char *build_names[ NUM_BUILDS ]      = { "generic", "fixed" };
+static const char *build_factories[ NUM_BUILDS ]  = { GENERIC_FACTORY_BIN, FACTORY_BIN };
+static const char *build_supervisors[ NUM_BUILDS ] = { GENERIC_SUPERVISOR_BIN, SUPERVISOR_BIN };
+
+
+static int byValue( const void *a, const void *b ) {
+
+    long long x = *(const long long*) a;
+    long long y = *(const long long*) b;
+
+    return ( x > y ) - ( x < y );
+}
+
+
+// CPU time used by reaped children so far, in nanoseconds
+static long long childCpu( void ) {
+
+    struct rusage ru;
+
+    if ( getrusage( RUSAGE_CHILDREN, &ru ) == -1 ) {
+        err_sys( "bench: getrusage failed" );
+    }
+
+    return ( ru.ru_utime.tv_sec + ru.ru_stime.tv_sec ) * 1000000000LL
+         + ( ru.ru_utime.tv_usec + ru.ru_stime.tv_usec ) * 1000LL;
+}
+
+
+void bench( int size, int repeats ) {
+
+    long long spans[ NUM_BUILDS ][ repeats ];
+    long long cpu[ NUM_BUILDS ][ repeats ];
+
+    drawSpecs( FLEET_SIZE );
+
+    printf( "BENCH: Order of %d parts on the fixed fleet of %d factories, no production time, %d run(s) each\n",
+        size, FLEET_SIZE, repeats );
+
+    for ( int i = 1; i < FLEET_SIZE + 1; i ++ ) {
+        printf( "BENCH: Factory #%3d Capacity=%4d Duration=%4d\n", i, capacities[i], durations[i] );
+    }
+
+
+    // alternate the builds, and which goes first, so drift over the
+    // benchmark does not favour either
+    fflush( stdout );
+    quiet = 1;
+
+    for ( int r = 0; r < repeats; r ++ ) {
+        for ( int k = 0; k < NUM_BUILDS; k ++ ) {
+
+            int b = ( r + k ) % NUM_BUILDS;
+
+            factory_bin    = build_factories[b];
+            supervisor_bin = build_supervisors[b];
+
+            long long before = childCpu();
+            spans[b][r] = runOrder( FLEET_SIZE, size, ORDER_POLICY, BENCH_TIME_SCALE );
+            cpu[b][r]   = childCpu() - before;
+        }
+
+        fprintf( stderr, "BENCH: %d of %d rounds done\r", r + 1, repeats );
+    }
+
+    quiet = 0;
+    fprintf( stderr, "\n" );
+
+    factory_bin    = FACTORY_BIN;
+    supervisor_bin = SUPERVISOR_BIN;
+
+
+    // Production takes no time, so the makespan is all overhead: starting the
+    // processes, claiming, reporting. CPU is what all the processes of one
+    // order used together.
+    long long median_span[ NUM_BUILDS ], median_cpu[ NUM_BUILDS ];
+
+    printf( "\n****** BENCH: Generic vs. Fixed Plant Build ******\n" );
+    printf( "Build     Makespan p50 (ms)   min (ms)   CPU p50 (ms)\n" );
+
+    for ( int b = 0; b < NUM_BUILDS; b ++ ) {
+
+        qsort( spans[b], repeats, sizeof(long long), byValue );
+        qsort( cpu[b],   repeats, sizeof(long long), byValue );
+
+        median_span[b] = spans[b][ repeats / 2 ];
+        median_cpu[b]  = cpu[b][ repeats / 2 ];
+
+        printf( "%-8s  %17.2f  %9.2f  %13.2f\n",
+            build_names[b], median_span[b] / 1e6, spans[b][0] / 1e6, median_cpu[b] / 1e6 );
+    }
+
+    printf( "\nBENCH: Fixed plant build makespan %+.1f%%, CPU %+.1f%% vs. generic\n",
+        100.0 * ( median_span[1] - median_span[0] ) / median_span[0],
+        median_cpu[0] > 0 ? 100.0 * ( median_cpu[1] - median_cpu[0] ) / median_cpu[0] : 0.0 );
+}
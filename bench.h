@@ -0,0 +1,20 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   bench.h
+----------------------------------------------------*/
+
+// Time compression of a benchmark order. It rounds every production sleep
+// down to 0, so what is left to measure is claiming, reporting and process
+// overhead, where the builds differ, and not production, where they do not.
+#define BENCH_TIME_SCALE    100000000
+
+// Default for sales_fixed -b
+#define BENCH_REPEATS       5       // runs per build, the median counts
+
+// Runs an order of 'size' parts on the compiled-in fleet with zero-duration
+// production, alternating the generic factory and supervisor binaries with
+// the fixed plant ones, and prints how the two builds compare.
+void    bench( int size, int repeats );
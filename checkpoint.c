@@ -0,0 +1,57 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   checkpoint.c
+----------------------------------------------------*/
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "wrappers.h"
+#include "shmem.h"
+#include "checkpoint.h"
+
+
+ckptFile *ckptOpen( const char *path ) {
+
+    int fd = open( path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR );
+    if ( fd == -1 ) {
+        err_sys( "ckptOpen: failed to open checkpoint" );
+    }
+
+    // a new file is zero filled, so its magic is not valid yet
+    Ftruncate( fd, sizeof(ckptFile) );
+    ckptFile *ck = (ckptFile*) Mmap( NULL, sizeof(ckptFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+    // the mapping keeps the file open
+    close( fd );
+
+    return ck;
+}
+
+
+void ckptClose( ckptFile *ck ) {
+    msync( ck, sizeof(ckptFile), MS_SYNC );
+    Munmap( ck, sizeof(ckptFile) );
+}
+
+
+void ckptCommit( ckptFile *ck, int made, int n, const int *parts_produced, const int *iterations ) {
+
+    int next = 1 - ck -> current;
+    ckptState *st = &ck -> state[next];
+
+    st -> made = made;
+    memcpy( st -> parts_produced, parts_produced, sizeof(int) * (n + 1) );
+    memcpy( st -> iterations,     iterations,     sizeof(int) * (n + 1) );
+
+    // the copy must be complete before it becomes the current one
+    __sync_synchronize();
+    ck -> current = next;
+    ck -> commits ++;
+
+    msync( ck, sizeof(ckptFile), MS_ASYNC );
+}
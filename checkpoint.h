@@ -0,0 +1,48 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   checkpoint.h
+----------------------------------------------------*/
+
+// File-backed order state, so an interrupted order can be resumed.
+// Include shmem.h first.
+//
+// Sales writes the order and the fleet once. The supervisor then commits
+// the reported progress after every batch of messages it handles. Commits
+// alternate between two copies of the state and flip 'current' last, so the
+// file always holds one consistent copy even if the supervisor is killed
+// in the middle of a commit.
+
+#define CKPT_MAGIC      0x50413243      // "PA2C"
+
+typedef struct
+{
+    int     made ;                              // #parts reported made
+    int     parts_produced[ MAXFACTORIES + 1 ] ;    // per factory, index 0 unused
+    int     iterations[ MAXFACTORIES + 1 ] ;
+} ckptState ;
+
+typedef struct
+{
+    int         magic ;         // CKPT_MAGIC once the header is filled in
+    int         order_size ;
+    int         fleet_size ;
+    int         capacities[ MAXFACTORIES + 1 ] ;
+    int         durations[ MAXFACTORIES + 1 ] ;
+    int         claim_sizes[ MAXFACTORIES + 1 ] ;
+
+    int         current ;       // index of the consistent copy of the state
+    long        commits ;
+    ckptState   state[2] ;
+} ckptFile ;
+
+// Maps the checkpoint at 'path', creating an empty one if needed.
+// An existing checkpoint has magic == CKPT_MAGIC.
+ckptFile   *ckptOpen( const char *path ) ;
+void        ckptClose( ckptFile *ck ) ;
+
+// Records the order's progress as the new consistent state. The per-factory
+// arrays hold factories 1..n, index 0 unused.
+void        ckptCommit( ckptFile *ck, int made, int n, const int *parts_produced, const int *iterations ) ;
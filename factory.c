@@ -16,18 +16,86 @@ File Name   :   factory.c
 #include "wrappers.h"
 #include "shmem.h"
 #include "message.h"
+#include "logseg.h"
+#include "lease.h"
+#include "queue.h"
+#include "latency.h"
+#include "fleet.h"
 
-#define LOG_MUTEX_NAME
-#define MEM_MUTEX_NAME
+#define MEM_MUTEX_NAME          "/leachjr_mem_mutex"
+
+
+// Sends a production report covering 'batches' iterations and 'parts' parts,
+// already taken off the factory's pending aggregate.
+static void sendPending( int mail_id, msgBuf *message, sem_t *shm_mutex, flowControl *flow,
+                         int parts, int batches ) {
+
+    message->purpose   = PRODUCTION_MSG;
+    message->partsMade = parts;
+    message->batches   = batches;
+    message->sentAt    = monotonicNanos();
+
+    if ( Msgsnd_lat( mail_id, message, MSG_INFO_SIZE, 0, LAT_SEND ) == -1 ) {
+        perror( "factory.c, production message failed to send" );
+    }
+
+    long long blocked = monotonicNanos() - message->sentAt;
+
+    Sem_wait( shm_mutex );
+    flow->blocked_ns += blocked;
+    Sem_post( shm_mutex );
+}
+
+
+// Sends whatever production is still pending, credit or not. Without one the
+// credits go negative until the supervisor hands this one back.
+static void flushPending( int mail_id, msgBuf *message, sem_t *shm_mutex, flowControl *flow ) {
+
+    Sem_wait( shm_mutex );
+    int parts   = flow->pending_parts;
+    int batches = flow->pending_batches;
+    if ( batches > 0 ) {
+        flow->credits --;
+        flow->pending_parts   = 0;
+        flow->pending_batches = 0;
+    }
+    Sem_post( shm_mutex );
+
+    if ( batches > 0 ) {
+        sendPending( mail_id, message, shm_mutex, flow, parts, batches );
+    }
+}
 
 
 int main (int argc, char** argv) {
     
     // get ints out of command line string args
     int id       = strtol( argv[1], NULL, 10 );
+
+#ifdef FIXED_FLEET
+    // the fleet is compiled in, only the ID comes from the command line
+    static const int fleet_capacities[ FLEET_SIZE + 1 ] = FLEET_CAPACITY_TABLE;
+    static const int fleet_durations[ FLEET_SIZE + 1 ]  = FLEET_DURATION_TABLE;
+
+    if ( id < 1 || id > FLEET_SIZE ) {
+        fprintf( stderr, "factory: this build has factories 1..%d, not %d\n", FLEET_SIZE, id );
+        exit( -1 );
+    }
+
+    int capacity = fleet_capacities[id];
+    int duration = fleet_durations[id];
+    int claim    = capacity;
+#else
     int capacity = strtol( argv[2], NULL, 10 );
     int duration = strtol( argv[3], NULL, 10 );
 
+    // optional 4th argument: how many parts to claim at a time
+    int claim    = argc > 4 ? strtol( argv[4], NULL, 10 ) : capacity;
+    if ( claim < 1 || claim > capacity ) {
+        claim = capacity;
+    }
+#endif
+
 
     // access IPC
 
@@ -40,10 +108,23 @@ int main (int argc, char** argv) {
     int shm_id = Shmget( key, SHMEM_SIZE, S_IRUSR | S_IWUSR );
     shData* data = (shData*) Shmat( shm_id, NULL, 0 );
 
-    // mutexes
-    sem_t* log_mutex = Sem_open2( LOG_MUTEX_NAME, 0 );
+#ifdef FIXED_FLEET
+    if ( data->fleet_size != FLEET_SIZE || data->claim_policy != FLEET_POLICY ) {
+        fprintf( stderr, "factory: order does not match the fleet this build was made for\n" );
+        exit( -1 );
+    }
+#endif
+
+    if ( data->latency ) {
+        latAttach();
+    }
+
+    // mutex
     sem_t* shm_mutex = Sem_open2( MEM_MUTEX_NAME, 0 );
 
+    // private log segment, merged into factory.log by sales
+    logSeg* log = segOpen( id );
+
 
     // initialize parts of the message that will never change
     msgBuf message;
@@ -51,66 +132,145 @@ int main (int argc, char** argv) {
     message.facID     = id;
     message.capacity  = capacity;
     message.duration  = duration;
+    message.batches   = 0;
 
 
     // initialize data for record keeping
     int parts_made = 0;
     int iterations = 0;
 
+    // production reported by the next message, taken off the pending
+    // aggregate in shared memory while holding a credit
+    int report_parts;
+    int report_batches;
+    flowControl *flow = &data->flow[id];
+
 
-    Sem_wait(log_mutex);
-    printf( "Factory # %2d: STARTED. My Capacity =%4d, in%5d milliSeconds\n",
+    segPrintf( log, "Factory # %2d: STARTED. My Capacity =%4d, in%5d milliSeconds\n",
         id, capacity, duration );
-    Sem_post(log_mutex);
 
 
     // initialize variables for production loop
     int batch_size;
+    int in_flight;
+    int closing;
     int working = 1;
 
+    // time actually spent making a batch. Autotuning runs compress time.
+    int time_scale = data->time_scale > 0 ? data->time_scale : 1;
+    useconds_t production_usec = (useconds_t) duration * 1000 / time_scale;
+
+    // a claim not finished within a few production durations is presumed lost
+    long long lease_ttl = (long long) production_usec * LEASE_TTL_FACTOR * 1000LL;
+    if ( lease_ttl < LEASE_TTL_MIN_MSEC * 1000000LL ) {
+        lease_ttl = LEASE_TTL_MIN_MSEC * 1000000LL;
+    }
+
     // IMPORTANT: while loop doesn't explicitly check remaining units because
     // that requires semaphore use which would be messy.
     while( working ) {
 
-        // default amount to create of product is capacity.
-        batch_size = capacity;
+        // default amount to create of product is the claim size.
+        batch_size = claim;
 
 
         // all operations with shared memory here.
-        Sem_wait(shm_mutex);
+        Sem_wait_lat( shm_mutex, LAT_CLAIM );
+
+        // put claims of dead or stuck factories back in the pool first
+        leaseReclaimStale( data );
+
+        // guided claims shrink as the order drains, so the factories finish together
+        if( POLICY_OF(data) == CLAIM_GUIDED ) {
+            int share = ( data->remain + FLEET_OF(data) - 1 ) / FLEET_OF(data);
+            if( share < batch_size ) {
+                batch_size = share;
+            }
+        }
 
-        // if the remaining items to produce is less than capacity, make all that remain.
+        // if the remaining items to produce is less than the claim, make all that remain.
         // This includes the case where there is nothing left to make, which is
         // checked outside of the "critical section"
-        if( data->remain < capacity ) {
+        if( data->remain < batch_size ) {
             batch_size = data->remain;
         }
-        data->remain -= batch_size;
+        if( batch_size > 0 ) {
+            leaseTake( data, id, batch_size, lease_ttl );
+        }
+        in_flight = data->leased;
+        closing   = data->closing;
 
         Sem_post(shm_mutex);
 
 
-        // if the amount that remained to make was 0, exit the loop
+        // if the amount that remained to make was 0, exit the loop once no other
+        // factory holds a claim. An outstanding claim may still come back to the pool.
+        // A resident factory reports everything and waits for the next batch instead.
         if( batch_size == 0 ) {
-            working = 0;
+            if( in_flight > 0 ) {
+                Usleep( LEASE_POLL_MSEC * 1000 / time_scale );
+            } else if( ! data->resident || closing ) {
+                working = 0;
+            } else {
+                flushPending( mail_id, &message, shm_mutex, flow );
+                Sem_wait( &data->work );
+            }
         } else {
             // log production
-            Sem_wait(log_mutex);
-            printf( "Factory # %2d: Going to make %5d parts in %4d milliSecs\n",
+            segPrintf( log, "Factory # %2d: Going to make %5d parts in %4d milliSecs\n",
                 id, batch_size, duration);
-            fflush(stdout);
-            Sem_post(log_mutex);
 
             // produce
-            Usleep( duration * 1000 );
+            long long started = monotonicNanos();
+            Usleep( production_usec );
+            long long busy = monotonicNanos() - started;
+
+            // hand the claim back. If it expired meanwhile another factory
+            // has been given these parts, so they must not be reported.
+            Sem_wait(shm_mutex);
+            int kept = leaseRelease( data, id );
+            report_parts   = 0;
+            report_batches = 0;
+            if( kept > 0 ) {
+                data->stages[0].batches ++;
+                data->stages[0].parts   += kept;
+                data->stages[0].busy_ns += busy;
+
+                // fold the batch into the pending report, and send that if we
+                // hold a credit. Otherwise keep producing and report it later.
+                flow->pending_parts += kept;
+                flow->pending_batches ++;
+
+                if( flow->credits > 0 ) {
+                    flow->credits --;
+                    report_parts   = flow->pending_parts;
+                    report_batches = flow->pending_batches;
+                    flow->pending_parts   = 0;
+                    flow->pending_batches = 0;
+                } else {
+                    flow->stalls ++;
+                }
+            }
+            Sem_post(shm_mutex);
 
-            // create production message.
-            message.purpose   = PRODUCTION_MSG;
-            message.partsMade = batch_size;
+            if( kept == 0 ) {
+                segPrintf( log, "Factory # %2d: Claim of %5d parts expired, discarding them\n",
+                    id, batch_size );
+                continue;
+            }
 
-            // send production message
-            if ( msgsnd( mail_id, &message, MSG_INFO_SIZE, 0 ) == -1 ) {
-                perror( "factory.c, production message failed to send" );
+            if( report_batches > 0 ) {
+                sendPending( mail_id, &message, shm_mutex, flow, report_parts, report_batches );
+            }
+
+            // pass the batch on to the rest of the pipeline
+            if( data->num_stages > 0 ) {
+                stageItem item = { batch_size, id };
+                long long blocked = queuePut( &data->queues[1], item );
+
+                Sem_wait(shm_mutex);
+                data->stages[0].blocked_ns += blocked;
+                Sem_post(shm_mutex);
             }
 
             // update production statistics
@@ -121,26 +281,34 @@ int main (int argc, char** argv) {
     }
 
 
+    // whatever is still pending goes out now
+    flushPending( mail_id, &message, shm_mutex, flow );
+
+
     // create completion message
     message.purpose = COMPLETION_MSG;
+    message.sentAt  = monotonicNanos();
 
     // send completion message
     if(msgsnd( mail_id, &message, MSG_INFO_SIZE, 0 ) == -1 ) {
         perror( "factory.c, completion message failed to send" );
     }
 
+    // from here on a restarted factory would complete a second time
+    Sem_wait(shm_mutex);
+    data->completed[id] = 1;
+    Sem_post(shm_mutex);
+
 
     // log completion
-    Sem_wait(log_mutex);
-    printf(
+    segPrintf( log,
         ">>> Factory # %3d: Terminating after making total of %5d parts in %5d iterations\n",
         id, parts_made, iterations
     );
-    Sem_post(log_mutex);
 
 
     // detach from IPC
-    Sem_close(log_mutex);
+    segClose( log );
     Shmdt( data );
 
 }
@@ -0,0 +1,67 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   fleet.h
+----------------------------------------------------*/
+
+// Fixed plant builds, make fixed. With FIXED_FLEET defined the fleet is a
+// compile-time constant instead of something read at run time:
+//
+//   FLEET_SIZE         number of factories
+//   FLEET_CAPACITIES   capacities of factories 1..FLEET_SIZE, comma separated
+//   FLEET_DURATIONS    durations of factories 1..FLEET_SIZE, comma separated
+//   FLEET_POLICY       claim policy, CLAIM_FIXED or CLAIM_GUIDED
+//
+// The makefile passes these in with -D. Include shmem.h first.
+//
+// What becomes constant is the factory specs, the fleet size and the claim
+// policy, so the policy branch and the guided share divide fold away, and
+// the stale lease scan has a fixed trip count. The claim loop is otherwise
+// the generic one: its cost is the shared memory mutex and the report
+// msgsnd, which a compile-time fleet does not change.
+
+#ifdef FIXED_FLEET
+
+#if !defined(FLEET_SIZE) || !defined(FLEET_CAPACITIES) || !defined(FLEET_DURATIONS) || !defined(FLEET_POLICY)
+#error "a fixed plant build needs FLEET_SIZE, FLEET_CAPACITIES, FLEET_DURATIONS and FLEET_POLICY"
+#endif
+
+#if FLEET_SIZE < 1 || FLEET_SIZE > MAXFACTORIES
+#error "FLEET_SIZE must be 1..MAXFACTORIES"
+#endif
+
+// initializers for tables indexed by factory ID, index 0 unused
+#define FLEET_CAPACITY_TABLE    { 0, FLEET_CAPACITIES }
+#define FLEET_DURATION_TABLE    { 0, FLEET_DURATIONS }
+
+// a table one entry short would leave its last factory at 0
+_Static_assert( sizeof( (int[]) FLEET_CAPACITY_TABLE ) == sizeof(int) * ( FLEET_SIZE + 1 ),
+    "FLEET_CAPACITIES must list exactly FLEET_SIZE capacities" );
+_Static_assert( sizeof( (int[]) FLEET_DURATION_TABLE ) == sizeof(int) * ( FLEET_SIZE + 1 ),
+    "FLEET_DURATIONS must list exactly FLEET_SIZE durations" );
+
+// fleet size and claim policy of the order in shared memory 'data'
+#define FLEET_OF(data)          FLEET_SIZE
+#define POLICY_OF(data)         FLEET_POLICY
+
+// the binaries sales runs, and the claim policy it orders with
+#define FACTORY_BIN             "./factory_fixed"
+#define SUPERVISOR_BIN          "./supervisor_fixed"
+#define ORDER_POLICY            FLEET_POLICY
+
+#else
+
+#define FLEET_OF(data)          ( (data) -> fleet_size )
+#define POLICY_OF(data)         ( (data) -> claim_policy )
+
+#define FACTORY_BIN             "./factory"
+#define SUPERVISOR_BIN          "./supervisor"
+#define ORDER_POLICY            CLAIM_FIXED
+
+#endif
+
+// the generic binaries, which a fixed plant build benchmarks against
+#define GENERIC_FACTORY_BIN     "./factory"
+#define GENERIC_SUPERVISOR_BIN  "./supervisor"
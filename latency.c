@@ -0,0 +1,194 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   latency.c
+----------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "wrappers.h"
+#include "latency.h"
+
+static const char *site_names[ LAT_SITES ] = { "claim", "send", "log", "receive" };
+
+static int        lat_id     = -1;
+static latRegion *lat_region = NULL;
+
+// this process's slot, NULL when not recording
+static latProc   *lat_self   = NULL;
+
+
+void latCreate( void ) {
+
+    key_t key = ftok( "latency.h", 0 );
+
+    lat_id     = Shmget( key, LAT_SIZE, IPC_CREAT | IPC_EXCL | S_IRUSR | S_IWUSR );
+    lat_region = (latRegion*) Shmat( lat_id, NULL, 0 );
+    memset( lat_region, 0, LAT_SIZE );
+}
+
+
+void latDestroy( void ) {
+
+    if ( lat_region == NULL ) {
+        return;
+    }
+
+    Shmdt( lat_region );
+    shmctl( lat_id, IPC_RMID, NULL );
+
+    lat_region = NULL;
+    lat_id     = -1;
+}
+
+
+void latAttach( void ) {
+
+    key_t key = ftok( "latency.h", 0 );
+
+    lat_id     = Shmget( key, LAT_SIZE, S_IRUSR | S_IWUSR );
+    lat_region = (latRegion*) Shmat( lat_id, NULL, 0 );
+
+    int slot = __sync_fetch_and_add( &lat_region -> nprocs, 1 );
+
+    // out of slots: this process just doesn't record
+    if ( slot < LAT_MAXPROCS ) {
+        lat_self = &lat_region -> procs[slot];
+        lat_self -> pid = getpid();
+    }
+}
+
+
+long long latStart( void ) {
+    return lat_self != NULL ? monotonicNanos() : 0;
+}
+
+
+// bucket holding 'v' nanoseconds
+static int latBucket( unsigned long long v ) {
+
+    if ( v < LAT_SUB ) {
+        return (int) v;
+    }
+
+    int e = 63 - __builtin_clzll( v );
+    int b = ( e - LAT_SUB_BITS + 1 ) * LAT_SUB + (int) ( ( v >> ( e - LAT_SUB_BITS ) ) & ( LAT_SUB - 1 ) );
+
+    return b < LAT_BUCKETS ? b : LAT_BUCKETS - 1;
+}
+
+
+// middle of the range of values that fall into bucket 'b'
+static double latBucketValue( int b ) {
+
+    if ( b < LAT_SUB ) {
+        return b;
+    }
+
+    int e = b / LAT_SUB + LAT_SUB_BITS - 1;
+    unsigned long long width = 1ULL << ( e - LAT_SUB_BITS );
+    unsigned long long low   = (unsigned long long) ( LAT_SUB + b % LAT_SUB ) * width;
+
+    return low + width / 2.0;
+}
+
+
+void latRecord( int site, long long start ) {
+
+    if ( lat_self == NULL ) {
+        return;
+    }
+
+    long long elapsed = monotonicNanos() - start;
+
+    lat_self -> count[site] ++;
+    lat_self -> buckets[site][ latBucket( elapsed > 0 ? elapsed : 0 ) ] ++;
+}
+
+
+//------------------------------------------------------------
+
+int Sem_wait_lat( sem_t *sem, int site ) {
+
+    long long start = latStart();
+    int code = Sem_wait( sem );
+    latRecord( site, start );
+
+    return code;
+}
+
+//------------------------------------------------------------
+
+int Msgsnd_lat( int id, const void *msg, size_t size, int flags, int site ) {
+
+    long long start = latStart();
+    int code = msgsnd( id, msg, size, flags );
+    latRecord( site, start );
+
+    return code;
+}
+
+//------------------------------------------------------------
+
+ssize_t Msgrcv_lat( int id, void *msg, size_t size, long type, int flags, int site ) {
+
+    long long start = latStart();
+    ssize_t code = msgrcv( id, msg, size, type, flags );
+    latRecord( site, start );
+
+    return code;
+}
+
+//------------------------------------------------------------
+
+void latReport( void ) {
+
+    static unsigned long merged[ LAT_BUCKETS ];
+
+    if ( lat_region == NULL ) {
+        return;
+    }
+
+    int nprocs = lat_region -> nprocs < LAT_MAXPROCS ? lat_region -> nprocs : LAT_MAXPROCS;
+    const double quantiles[] = { 0.50, 0.99, 0.999 };
+
+    printf( "\n****** SUPERVISOR: Latency (usec) ******\n" );
+    printf( "Site        Count        p50        p99       p999\n" );
+
+    for ( int site = 0; site < LAT_SITES; site ++ ) {
+
+        unsigned long total = 0;
+        memset( merged, 0, sizeof(merged) );
+
+        for ( int p = 0; p < nprocs; p ++ ) {
+            total += lat_region -> procs[p].count[site];
+            for ( int b = 0; b < LAT_BUCKETS; b ++ ) {
+                merged[b] += lat_region -> procs[p].buckets[site][b];
+            }
+        }
+
+        printf( "%-8s %8lu", site_names[site], total );
+
+        for ( int q = 0; q < 3; q ++ ) {
+
+            // smallest bucket that covers the quantile's rank
+            unsigned long rank = (unsigned long) ( quantiles[q] * total + 0.999999 );
+            unsigned long seen = 0;
+            int b = 0;
+
+            while ( b < LAT_BUCKETS - 1 && seen + merged[b] < rank ) {
+                seen += merged[b];
+                b ++;
+            }
+
+            printf( " %10.1f", total ? latBucketValue( b ) / 1000.0 : 0.0 );
+        }
+
+        printf( "\n" );
+    }
+}
@@ -0,0 +1,69 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   latency.h
+----------------------------------------------------*/
+
+#include <semaphore.h>
+#include <sys/types.h>
+
+// Optional latency histograms for the hot IPC calls, turned on with sales -l.
+//
+// Every process that records gets its own slot in a shared memory region,
+// so recording never takes a lock. The supervisor merges the slots for its
+// final report. When recording is off the timed wrappers cost one branch.
+
+// call sites that are timed
+typedef enum
+{
+    LAT_CLAIM = 0 ,     // factory waiting for the shared memory mutex to claim parts
+    LAT_SEND ,          // factory sending a production message
+    LAT_LOG ,           // factory writing a line to its log segment
+    LAT_RECV ,          // supervisor blocked waiting for a message
+    LAT_SITES
+} latSite_t ;
+
+// Log-bucketed histogram, HDR style: values below LAT_SUB get their own
+// bucket, above that every power of two is split into LAT_SUB buckets.
+// That keeps the relative error under 1/LAT_SUB at any magnitude.
+#define LAT_SUB_BITS    4
+#define LAT_SUB         ( 1 << LAT_SUB_BITS )
+#define LAT_MAX_EXP     36                      // 2^36 ns, about 68 seconds
+#define LAT_BUCKETS     ( ( LAT_MAX_EXP - LAT_SUB_BITS + 2 ) * LAT_SUB )
+#define LAT_MAXPROCS    64
+
+typedef struct
+{
+    pid_t           pid ;
+    unsigned long   count[ LAT_SITES ] ;
+    unsigned long   buckets[ LAT_SITES ][ LAT_BUCKETS ] ;
+} latProc ;
+
+typedef struct
+{
+    int             nprocs ;    // slots handed out
+    latProc         procs[ LAT_MAXPROCS ] ;
+} latRegion ;
+
+#define LAT_SIZE        sizeof(latRegion)
+
+// sales: create and remove the region
+void        latCreate( void ) ;
+void        latDestroy( void ) ;
+
+// every process that records or reports: attach and take a slot
+void        latAttach( void ) ;
+
+// time an arbitrary section: t = latStart(); ... latRecord( site, t );
+long long   latStart( void ) ;
+void        latRecord( int site, long long start ) ;
+
+// timed variants of the IPC wrappers
+int         Sem_wait_lat( sem_t *sem, int site ) ;
+int         Msgsnd_lat( int id, const void *msg, size_t size, int flags, int site ) ;
+ssize_t     Msgrcv_lat( int id, void *msg, size_t size, long type, int flags, int site ) ;
+
+// supervisor: merge every slot and print p50/p99/p999 per site
+void        latReport( void ) ;
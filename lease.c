@@ -0,0 +1,96 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   lease.c
+----------------------------------------------------*/
+
+#include <unistd.h>
+
+#include "wrappers.h"
+#include "shmem.h"
+#include "lease.h"
+#include "fleet.h"
+
+
+void leaseTake( shData *data, int id, int parts, long long ttl ) {
+
+    claimLease *l = &data -> leases[id];
+
+    l -> owner    = getpid();
+    l -> parts    = parts;
+    l -> deadline = monotonicNanos() + ttl;
+
+    data -> remain -= parts;
+    data -> leased += parts;
+}
+
+
+int leaseRelease( shData *data, int id ) {
+
+    claimLease *l = &data -> leases[id];
+
+    // someone else decided we were dead and gave the parts away
+    if ( l -> owner != getpid() ) {
+        return 0;
+    }
+
+    int parts = l -> parts;
+
+    l -> owner = 0;
+    l -> parts = 0;
+
+    data -> leased -= parts;
+    data -> made   += parts;
+
+    return parts;
+}
+
+
+int leaseReclaim( shData *data, int id ) {
+
+    claimLease *l = &data -> leases[id];
+
+    if ( l -> owner == 0 ) {
+        return 0;
+    }
+
+    int parts = l -> parts;
+
+    l -> owner = 0;
+    l -> parts = 0;
+
+    data -> leased    -= parts;
+    data -> remain    += parts;
+    data -> reclaimed += parts;
+
+    return parts;
+}
+
+
+int leaseReclaimStale( shData *data ) {
+
+    long long now = monotonicNanos();
+    int parts = 0;
+
+    // only factories 1..fleet size ever hold a lease. In a fixed plant build
+    // that bound is a constant.
+    for ( int i = 1; i < FLEET_OF(data) + 1; i ++ ) {
+
+        claimLease *l = &data -> leases[i];
+
+        if ( l -> owner == 0 ) {
+            continue;
+        }
+
+        // A dead owner is not checked for here: until sales reaps it, it is a
+        // zombie that kill( pid, 0 ) still finds. Sales takes its claim back
+        // when it reaps it, see orderReap().
+        if ( l -> deadline < now ) {
+            parts += leaseReclaim( data, i );
+        }
+    }
+
+    return parts;
+}
@@ -0,0 +1,34 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   lease.h
+----------------------------------------------------*/
+
+// Claim leases on the shared order. Include shmem.h first.
+// Every function here must be called with the shared memory mutex held.
+
+// A factory's claim expires after this many of its production durations
+#define LEASE_TTL_FACTOR    3
+
+// but never sooner than this, so time-compressed runs do not expire claims
+// just because the machine is busy
+#define LEASE_TTL_MIN_MSEC  100
+
+// How long an idle factory waits before checking whether a claim it is
+// waiting on has come back to the pool
+#define LEASE_POLL_MSEC     50
+
+// Takes 'parts' out of remain and records them as leased by this process
+void    leaseTake( shData *data, int id, int parts, long long ttl ) ;
+
+// Ends factory 'id's lease after it made the parts. Returns the #parts
+// to count as made, or 0 if the lease had been taken back in the meantime.
+int     leaseRelease( shData *data, int id ) ;
+
+// Returns factory 'id's leased parts to the pool. Returns the #parts returned.
+int     leaseReclaim( shData *data, int id ) ;
+
+// Returns every expired lease to the pool. Returns the #parts returned.
+int     leaseReclaimStale( shData *data ) ;
@@ -0,0 +1,203 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   logseg.c
+----------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "wrappers.h"
+#include "logseg.h"
+#include "latency.h"
+
+// rounds a record up so the next one starts 8-byte aligned
+#define SEG_ALIGN(x)    ( ( (x) + 7 ) & ~(size_t) 7 )
+
+
+void segName( char *buf, size_t len, int id ) {
+    snprintf( buf, len, "factory.%d.seg", id );
+}
+
+
+// maps the first 'size' bytes of the segment file
+static void segMap( logSeg *seg, size_t size ) {
+    Ftruncate( seg -> fd, size );
+    seg -> base = (char*) Mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, seg -> fd, 0 );
+    seg -> size = size;
+}
+
+
+logSeg *segOpen( int id ) {
+
+    char name[32];
+    struct stat st;
+
+    segName( name, sizeof(name), id );
+
+    logSeg *seg = (logSeg*) malloc( sizeof(logSeg) );
+    if ( seg == NULL ) {
+        err_sys( "segOpen: malloc failed" );
+    }
+
+    seg -> fd = open( name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR );
+    if ( seg -> fd == -1 ) {
+        err_sys( "segOpen: failed to open log segment" );
+    }
+
+    if ( fstat( seg -> fd, &st ) == -1 ) {
+        err_sys( "segOpen: fstat failed" );
+    }
+
+    // a fresh file is zero filled by ftruncate, so 'used' starts at 0
+    segMap( seg, st.st_size > SEG_INITIAL_SIZE ? st.st_size : SEG_INITIAL_SIZE );
+
+    return seg;
+}
+
+
+void segPrintf( logSeg *seg, const char *fmt, ... ) {
+
+    char line[SEG_LINE_MAX];
+    va_list args;
+
+    long long start = latStart();
+
+    va_start( args, fmt );
+    int len = vsnprintf( line, sizeof(line), fmt, args );
+    va_end( args );
+
+    if ( len >= (int) sizeof(line) ) {
+        len = sizeof(line) - 1;
+    }
+
+    segHeader *header = (segHeader*) seg -> base;
+    size_t need = SEG_ALIGN( sizeof(segRecord) + len );
+
+    // grow the file and remap when the record does not fit
+    if ( sizeof(segHeader) + header -> used + need > seg -> size ) {
+        size_t size = seg -> size;
+        Munmap( seg -> base, size );
+        segMap( seg, size * 2 );
+        header = (segHeader*) seg -> base;
+    }
+
+    segRecord *rec = (segRecord*) ( seg -> base + sizeof(segHeader) + header -> used );
+    rec -> stamp = monotonicNanos();
+    rec -> len   = len;
+    memcpy( rec + 1, line, len );
+
+    // publish the record last, so a factory that dies mid-write leaves
+    // a segment that ends at its last complete line
+    header -> used += need;
+
+    latRecord( LAT_LOG, start );
+}
+
+
+void segClose( logSeg *seg ) {
+    Munmap( seg -> base, seg -> size );
+    close( seg -> fd );
+    free( seg );
+}
+
+
+void segRemove( int n ) {
+
+    char name[32];
+
+    for ( int i = 1; i < n + 1; i ++ ) {
+        segName( name, sizeof(name), i );
+        unlink( name );
+    }
+}
+
+
+void segMerge( int n, const char *path ) {
+
+    char name[32];
+    struct stat st;
+
+    // one read cursor per segment. Index 0 is unused so ids index directly.
+    char   **base   = (char**)  calloc( n + 1, sizeof(char*) );
+    size_t  *size   = (size_t*) calloc( n + 1, sizeof(size_t) );
+    size_t  *pos    = (size_t*) calloc( n + 1, sizeof(size_t) );
+    size_t  *end    = (size_t*) calloc( n + 1, sizeof(size_t) );
+
+    if ( base == NULL || size == NULL || pos == NULL || end == NULL ) {
+        err_sys( "segMerge: calloc failed" );
+    }
+
+    for ( int i = 1; i < n + 1; i ++ ) {
+        segName( name, sizeof(name), i );
+
+        int fd = open( name, O_RDONLY );
+        if ( fd == -1 ) {
+            continue;   // factory never got to log anything
+        }
+
+        if ( fstat( fd, &st ) == -1 ) {
+            err_sys( "segMerge: fstat failed" );
+        }
+
+        if ( st.st_size >= (off_t) sizeof(segHeader) ) {
+            size[i] = st.st_size;
+            base[i] = (char*) Mmap( NULL, size[i], PROT_READ, MAP_SHARED, fd, 0 );
+            pos[i]  = sizeof(segHeader);
+            end[i]  = sizeof(segHeader) + ( (segHeader*) base[i] ) -> used;
+        }
+        close( fd );
+    }
+
+    FILE *out = fopen( path, "w" );
+    if ( out == NULL ) {
+        err_sys( "segMerge: failed to open merged log" );
+    }
+
+    // k-way merge. Sales refuses fleets wider than MAXFACTORIES, so a
+    // linear scan for the oldest head record is cheaper than keeping a heap.
+    while ( 1 ) {
+
+        int oldest = 0;
+        long long stamp = 0;
+
+        for ( int i = 1; i < n + 1; i ++ ) {
+            if ( pos[i] < end[i] ) {
+                segRecord *rec = (segRecord*) ( base[i] + pos[i] );
+                if ( oldest == 0 || rec -> stamp < stamp ) {
+                    oldest = i;
+                    stamp  = rec -> stamp;
+                }
+            }
+        }
+
+        if ( oldest == 0 ) {
+            break;
+        }
+
+        segRecord *rec = (segRecord*) ( base[oldest] + pos[oldest] );
+        fwrite( rec + 1, 1, rec -> len, out );
+        pos[oldest] += SEG_ALIGN( sizeof(segRecord) + rec -> len );
+    }
+
+    fclose( out );
+
+    for ( int i = 1; i < n + 1; i ++ ) {
+        if ( base[i] != NULL ) {
+            Munmap( base[i], size[i] );
+        }
+    }
+    segRemove( n );
+
+    free( base );
+    free( size );
+    free( pos );
+    free( end );
+}
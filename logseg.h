@@ -0,0 +1,49 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   logseg.h
+----------------------------------------------------*/
+
+#include <stddef.h>
+
+// Every factory logs into its own memory-mapped file, factory.<id>.seg,
+// so factories never contend on a log mutex. Sales merges the segments
+// into factory.log by timestamp once the factories are gone.
+
+typedef struct
+{
+    size_t  used ;          // bytes of records that follow the header
+} segHeader ;
+
+typedef struct
+{
+    long long stamp ;       // monotonicNanos() when the line was logged
+    int       len ;         // length of the text that follows the record
+} segRecord ;               // text is padded so the next record is 8-byte aligned
+
+typedef struct
+{
+    int     fd ;
+    size_t  size ;          // current size of the file and of the mapping
+    char   *base ;          // segHeader, then the records
+} logSeg ;
+
+#define SEG_INITIAL_SIZE    ( 64 * 1024 )
+#define SEG_LINE_MAX        256
+
+void    segName( char *buf, size_t len, int id ) ;
+
+// Opens the segment for factory 'id', creating it if it does not exist.
+// An existing segment is appended to, so a restarted factory keeps its history.
+logSeg *segOpen( int id ) ;
+void    segPrintf( logSeg *seg, const char *fmt, ... ) ;
+void    segClose( logSeg *seg ) ;
+
+// Removes the segments of factories 1..n
+void    segRemove( int n ) ;
+
+// Merges the segments of factories 1..n into 'path' in timestamp order,
+// then removes them.
+void    segMerge( int n, const char *path ) ;
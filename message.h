@@ -18,7 +18,10 @@ typedef struct {
     int  facID    ,          /* sender's Factory ID */
          capacity ,          /* #of parts made in most recent iteration */
          partsMade ,         /* #of parts made in most recent iteration */
-         duration ;          /* how long it took to make them */
+         duration ,          /* how long it took to make them */
+         batches ;           /* #iterations folded into this report */
+
+    long long sentAt ;       /* monotonicNanos() when the message was sent */
 
 } msgBuf ;
 
@@ -0,0 +1,335 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   order.c
+----------------------------------------------------*/
+
+// Client for the order admission service, sales -d.
+//
+//   order <socket> <size>                          place one order and wait for it
+//   order -s <socket>                              shut the service down
+//   order -l <socket> <rate/sec> <count> <size>    load test: Poisson arrivals,
+//                                                  then throughput and latency
+//
+// The load test opens one connection per order, so it measures exactly what
+// a stream of independent customers would see.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "wrappers.h"
+#include "admission.h"
+
+typedef struct
+{
+    int         fd ;            // -1 once the order is over
+    int         len ;
+    char        buf[ ADMIT_LINE_MAX ] ;
+    long long   sent ;          // monotonicNanos() when the order went out
+    long long   started ;       // ... when its batch started, 0 until then
+} pending ;
+
+
+// connects to the service and sends it one request line
+static int request( const char *path, const char *line ) {
+
+    struct sockaddr_un addr;
+
+    int fd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    if ( fd == -1 ) {
+        err_sys( "order: socket failed" );
+    }
+
+    memset( &addr, 0, sizeof(addr) );
+    addr.sun_family = AF_UNIX;
+    snprintf( addr.sun_path, sizeof(addr.sun_path), "%s", path );
+
+    if ( connect( fd, (struct sockaddr*) &addr, sizeof(addr) ) == -1 ) {
+        close( fd );
+        return -1;
+    }
+
+    if ( send( fd, line, strlen( line ), MSG_NOSIGNAL ) == -1 ) {
+        close( fd );
+        return -1;
+    }
+
+    return fd;
+}
+
+
+// reads what arrived for order 'p'. Returns the complete lines one at a time,
+// NULL when none is left. Sets p -> fd to -1 when the service hung up.
+static char *nextLine( pending *p, int fill ) {
+
+    static char line[ ADMIT_LINE_MAX ];
+
+    if ( fill ) {
+        int got = read( p -> fd, p -> buf + p -> len, sizeof(p -> buf) - 1 - p -> len );
+        if ( got <= 0 ) {
+            close( p -> fd );
+            p -> fd = -1;
+            return NULL;
+        }
+        p -> len += got;
+    }
+
+    p -> buf[ p -> len ] = '\0';
+    char *end = strchr( p -> buf, '\n' );
+    if ( end == NULL ) {
+        return NULL;
+    }
+
+    int len = end - p -> buf;
+    memcpy( line, p -> buf, len );
+    line[len] = '\0';
+
+    p -> len -= len + 1;
+    memmove( p -> buf, end + 1, p -> len );
+
+    return line;
+}
+
+
+static int cmpLong( const void *a, const void *b ) {
+    long long x = *(const long long*) a, y = *(const long long*) b;
+    return x < y ? -1 : x > y;
+}
+
+
+// places one order and prints every notice about it until it is done
+static int placeOne( const char *path, int size ) {
+
+    char line[ ADMIT_LINE_MAX ];
+    pending p = { 0 };
+
+    snprintf( line, sizeof(line), "ORDER %d\n", size );
+
+    p.fd = request( path, line );
+    if ( p.fd == -1 ) {
+        err_sys( "order: cannot reach the service" );
+    }
+
+    while ( p.fd != -1 ) {
+
+        char *notice;
+        int fill = 1;
+
+        while ( ( notice = nextLine( &p, fill ) ) != NULL ) {
+            fill = 0;
+            printf( "%s\n", notice );
+
+            if ( strncmp( notice, "DONE", 4 ) == 0 || strncmp( notice, "REJECTED", 8 ) == 0
+                    || strncmp( notice, "FAILED", 6 ) == 0 ) {
+                close( p.fd );
+                return strncmp( notice, "DONE", 4 ) == 0 ? 0 : 1;
+            }
+        }
+    }
+
+    printf( "service hung up\n" );
+    return 1;
+}
+
+
+// offers 'count' orders of 'size' parts at 'rate' per second on average
+static void loadTest( const char *path, double rate, int count, int size ) {
+
+    char line[ ADMIT_LINE_MAX ];
+    snprintf( line, sizeof(line), "ORDER %d\n", size );
+
+    pending   *orders  = (pending*)   calloc( count, sizeof(pending) );
+    long long *e2e     = (long long*) calloc( count, sizeof(long long) );
+    long long *waits   = (long long*) calloc( count, sizeof(long long) );
+    struct pollfd *fds = (struct pollfd*) calloc( count, sizeof(struct pollfd) );
+    int       *which   = (int*)       calloc( count, sizeof(int) );
+
+    if ( orders == NULL || e2e == NULL || waits == NULL || fds == NULL || which == NULL ) {
+        err_sys( "order: calloc failed" );
+    }
+
+    int sent = 0, open = 0, done = 0, rejected = 0, failed = 0, lost = 0;
+
+    long long begin = monotonicNanos();
+    long long next  = begin;
+
+    while ( sent < count || open > 0 ) {
+
+        // place every order that is due
+        long long now = monotonicNanos();
+
+        while ( sent < count && next <= now ) {
+
+            pending *p = &orders[ sent ++ ];
+            p -> fd   = request( path, line );
+            p -> sent = monotonicNanos();
+
+            if ( p -> fd == -1 ) {
+                lost ++;
+            } else {
+                open ++;
+            }
+
+            // exponential gaps make the arrivals a Poisson process
+            double u = ( random() + 1.0 ) / ( RAND_MAX + 2.0 );
+            next += (long long) ( -log( u ) / rate * 1e9 );
+        }
+
+        // wait for notices until the next order is due
+        int nfds = 0;
+        for ( int i = 0; i < sent; i ++ ) {
+            if ( orders[i].fd != -1 ) {
+                fds[nfds].fd     = orders[i].fd;
+                fds[nfds].events = POLLIN;
+                which[nfds]      = i;
+                nfds ++;
+            }
+        }
+
+        int timeout = -1;
+        if ( sent < count ) {
+            long long left = next - monotonicNanos();
+            timeout = left > 0 ? (int) ( left / 1000000 ) + 1 : 0;
+        }
+
+        if ( poll( fds, nfds, timeout ) == -1 ) {
+            if ( errno == EINTR ) {
+                continue;
+            }
+            err_sys( "order: poll failed" );
+        }
+
+        for ( int k = 0; k < nfds; k ++ ) {
+
+            if ( fds[k].revents == 0 ) {
+                continue;
+            }
+
+            pending *p = &orders[ which[k] ];
+            char *notice;
+            int fill = 1;
+
+            while ( p -> fd != -1 && ( notice = nextLine( p, fill ) ) != NULL ) {
+                fill = 0;
+
+                if ( strncmp( notice, "STARTED", 7 ) == 0 ) {
+                    p -> started = monotonicNanos();
+
+                } else if ( strncmp( notice, "DONE", 4 ) == 0 ) {
+                    long long end = monotonicNanos();
+                    waits[done] = ( p -> started ? p -> started : end ) - p -> sent;
+                    e2e[done]   = end - p -> sent;
+                    done ++;
+
+                    close( p -> fd );
+                    p -> fd = -1;
+                    open --;
+
+                } else if ( strncmp( notice, "REJECTED", 8 ) == 0 || strncmp( notice, "FAILED", 6 ) == 0 ) {
+                    if ( notice[0] == 'R' ) {
+                        rejected ++;
+                    } else {
+                        failed ++;
+                    }
+
+                    close( p -> fd );
+                    p -> fd = -1;
+                    open --;
+                }
+            }
+
+            // hung up before the order was done
+            if ( p -> fd == -1 && fill ) {
+                lost ++;
+                open --;
+            }
+        }
+    }
+
+    double elapsed = ( monotonicNanos() - begin ) / 1e9;
+
+    printf( "\n****** ORDER: Load test of %d orders of %d parts at %.1f/sec ******\n", count, size, rate );
+    printf( "Done = %d   Rejected = %d   Failed = %d   Lost = %d   in %.3f sec\n",
+        done, rejected, failed, lost, elapsed );
+    printf( "Throughput = %.2f orders/sec   %.1f parts/sec\n", done / elapsed, (double) done * size / elapsed );
+
+    if ( done > 0 ) {
+        qsort( e2e,   done, sizeof(long long), cmpLong );
+        qsort( waits, done, sizeof(long long), cmpLong );
+
+        long long sum = 0, wsum = 0;
+        for ( int i = 0; i < done; i ++ ) {
+            sum  += e2e[i];
+            wsum += waits[i];
+        }
+
+        const double quantiles[] = { 0.50, 0.90, 0.99 };
+
+        printf( "Latency (msec)     avg        p50        p90        p99        max\n" );
+
+        printf( "end to end  %10.1f", sum / 1e6 / done );
+        for ( int q = 0; q < 3; q ++ ) {
+            printf( " %10.1f", e2e[ (int) ( quantiles[q] * ( done - 1 ) ) ] / 1e6 );
+        }
+        printf( " %10.1f\n", e2e[ done - 1 ] / 1e6 );
+
+        printf( "admission   %10.1f", wsum / 1e6 / done );
+        for ( int q = 0; q < 3; q ++ ) {
+            printf( " %10.1f", waits[ (int) ( quantiles[q] * ( done - 1 ) ) ] / 1e6 );
+        }
+        printf( " %10.1f\n", waits[ done - 1 ] / 1e6 );
+    }
+
+    free( orders );
+    free( e2e );
+    free( waits );
+    free( fds );
+    free( which );
+}
+
+
+int main (int argc, char** argv) {
+
+    srandom( getpid() );
+
+    if ( argc == 3 && strcmp( argv[1], "-s" ) == 0 ) {
+        int fd = request( argv[2], "SHUTDOWN\n" );
+        if ( fd == -1 ) {
+            err_sys( "order: cannot reach the service" );
+        }
+        close( fd );
+        return 0;
+    }
+
+    if ( argc == 6 && strcmp( argv[1], "-l" ) == 0 ) {
+        double rate = strtod( argv[3], NULL );
+        int count   = strtol( argv[4], NULL, 10 );
+        int size    = strtol( argv[5], NULL, 10 );
+
+        if ( rate <= 0 || count < 1 || size < 1 ) {
+            printf( "usage: order -l <socket> <rate/sec> <count> <size>\n" );
+            exit( -1 );
+        }
+
+        loadTest( argv[2], rate, count, size );
+        return 0;
+    }
+
+    if ( argc == 3 && argv[1][0] != '-' ) {
+        return placeOne( argv[1], strtol( argv[2], NULL, 10 ) );
+    }
+
+    printf( "usage: order <socket> <size>\n"
+            "       order -s <socket>\n"
+            "       order -l <socket> <rate/sec> <count> <size>\n" );
+    exit( -1 );
+}
@@ -0,0 +1,87 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   queue.c
+----------------------------------------------------*/
+
+#include "wrappers.h"
+#include "shmem.h"
+#include "queue.h"
+
+
+void queueInit( stageQueue *q ) {
+
+    // pshared = 1, the queue lives in shared memory
+    Sem_init( &q -> slots, 1, STAGE_QUEUE_CAP );
+    Sem_init( &q -> items, 1, 0 );
+    Sem_init( &q -> mutex, 1, 1 );
+
+    q -> head  = 0;
+    q -> tail  = 0;
+    q -> count = 0;
+
+    q -> samples       = 0;
+    q -> occupancy_sum = 0;
+    q -> occupancy_max = 0;
+}
+
+
+void queueDestroy( stageQueue *q ) {
+    Sem_destroy( &q -> slots );
+    Sem_destroy( &q -> items );
+    Sem_destroy( &q -> mutex );
+}
+
+
+long long queuePut( stageQueue *q, stageItem item ) {
+
+    long long blocked = 0;
+
+    // only read the clock when we actually have to wait
+    if ( sem_trywait( &q -> slots ) != 0 ) {
+        long long start = monotonicNanos();
+        Sem_wait( &q -> slots );
+        blocked = monotonicNanos() - start;
+    }
+
+    Sem_wait( &q -> mutex );
+
+    q -> ring[ q -> tail ] = item;
+    q -> tail = ( q -> tail + 1 ) % STAGE_QUEUE_CAP;
+    q -> count ++;
+
+    q -> samples ++;
+    q -> occupancy_sum += q -> count;
+    if ( q -> count > q -> occupancy_max ) {
+        q -> occupancy_max = q -> count;
+    }
+
+    Sem_post( &q -> mutex );
+    Sem_post( &q -> items );
+
+    return blocked;
+}
+
+
+stageItem queueGet( stageQueue *q, char *ended ) {
+
+    stageItem item;
+
+    Sem_wait( &q -> items );
+    Sem_wait( &q -> mutex );
+
+    item = q -> ring[ q -> head ];
+    q -> head = ( q -> head + 1 ) % STAGE_QUEUE_CAP;
+    q -> count --;
+
+    if ( item.parts == 0 ) {
+        *ended = WORKER_ENDING;
+    }
+
+    Sem_post( &q -> mutex );
+    Sem_post( &q -> slots );
+
+    return item;
+}
@@ -0,0 +1,21 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   queue.h
+----------------------------------------------------*/
+
+// Bounded inter-stage queues in shared memory. Include shmem.h first.
+
+void        queueInit( stageQueue *q ) ;
+void        queueDestroy( stageQueue *q ) ;
+
+// Adds a batch, waiting for a free slot if the queue is full.
+// Returns how long it had to wait, in nanoseconds.
+long long   queuePut( stageQueue *q, stageItem item ) ;
+
+// Removes the oldest batch, waiting for one if the queue is empty. If it is
+// the end of production marker, sets *ended to WORKER_ENDING before letting
+// go of the queue, so a worker cannot die holding a marker nobody knows about.
+stageItem   queueGet( stageQueue *q, char *ended ) ;
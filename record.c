@@ -0,0 +1,93 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   record.c
+----------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "wrappers.h"
+#include "record.h"
+
+
+FILE *recOpen( const char *path ) {
+
+    FILE *rec = fopen( path, "w" );
+    if ( rec == NULL ) {
+        err_sys( "recOpen: failed to open record stream" );
+    }
+
+    setvbuf( rec, NULL, _IOFBF, REC_BUFFER_SIZE );
+
+    return rec;
+}
+
+
+void recEvent( FILE *rec, const char *ev, const char *fields, ... ) {
+
+    struct timespec ts;
+    va_list args;
+
+    Clock_gettime( CLOCK_REALTIME, &ts );
+
+    fprintf( rec, "{\"t\":%lld,\"ev\":\"%s\"",
+        (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec, ev );
+
+    if ( fields[0] != '\0' ) {
+        fputc( ',', rec );
+        va_start( args, fields );
+        vfprintf( rec, fields, args );
+        va_end( args );
+    }
+
+    fputs( "}\n", rec );
+}
+
+
+void recFlush( FILE *rec ) {
+    fflush( rec );
+}
+
+
+void recClose( FILE *rec ) {
+    fclose( rec );
+}
+
+
+long long recField( const char *line, const char *key, long long dflt ) {
+
+    char pattern[64];
+
+    snprintf( pattern, sizeof(pattern), "\"%s\":", key );
+
+    const char *p = strstr( line, pattern );
+    if ( p == NULL ) {
+        return dflt;
+    }
+
+    return strtoll( p + strlen( pattern ), NULL, 10 );
+}
+
+
+int recType( const char *line, char *ev, size_t len ) {
+
+    const char *p = strstr( line, "\"ev\":\"" );
+    if ( p == NULL ) {
+        return 0;
+    }
+    p += 6;
+
+    size_t i = 0;
+    while ( p[i] != '"' && p[i] != '\0' && i + 1 < len ) {
+        ev[i] = p[i];
+        i ++;
+    }
+    ev[i] = '\0';
+
+    return 1;
+}
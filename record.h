@@ -0,0 +1,40 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   record.h
+----------------------------------------------------*/
+
+#include <stdio.h>
+
+// Structured record stream written by the supervisor next to supervisor.log.
+// One JSON object per line, each with the wall clock time "t" in nanoseconds
+// and the event type "ev":
+//
+//   start        factories, order
+//   production   fac, parts, iterations, duration, latency_ns
+//   completion   fac
+//   factory      fac, parts, iterations           (final totals)
+//   summary      made, order, reclaimed
+//
+// The stream is buffered and flushed once per batch of messages, so readers
+// see it grow while the order is running. See report.c for a reader.
+
+#define REC_PATH            "supervisor.ndjson"
+#define REC_BUFFER_SIZE     ( 64 * 1024 )
+
+FILE   *recOpen( const char *path ) ;
+
+// Writes one record. 'fields' is a printf format for the fields after
+// "t" and "ev", e.g. "\"fac\":%d", or "" for none.
+void    recEvent( FILE *rec, const char *ev, const char *fields, ... ) ;
+
+void    recFlush( FILE *rec ) ;
+void    recClose( FILE *rec ) ;
+
+// Reader side: the integer value of "key" in a record line, or 'dflt' if it is missing
+long long recField( const char *line, const char *key, long long dflt ) ;
+
+// Reader side: copies the "ev" of a record line into 'ev'. Returns 0 if there is none.
+int     recType( const char *line, char *ev, size_t len ) ;
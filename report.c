@@ -0,0 +1,164 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   report.c
+----------------------------------------------------*/
+
+// Reads the supervisor's record stream and summarizes it.
+//
+//   report [-f] [file]
+//
+// With -f the stream is followed while the order is running, printing
+// progress as records arrive, until the supervisor writes its summary.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wrappers.h"
+#include "shmem.h"
+#include "record.h"
+
+// how often a followed stream is checked for new records
+#define FOLLOW_POLL_MSEC    200
+
+#define LINE_MAX_LEN        512
+
+
+int main (int argc, char** argv) {
+
+    int follow = 0;
+    const char *path = REC_PATH;
+
+    for ( int i = 1; i < argc; i ++ ) {
+        if ( strcmp( argv[i], "-f" ) == 0 ) {
+            follow = 1;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    FILE *in = fopen( path, "r" );
+    if ( in == NULL ) {
+        err_sys( "report: failed to open record stream" );
+    }
+
+
+    // what the stream told us so far. Indexed by factory ID, index 0 unused.
+    long parts[ MAXFACTORIES + 1 ]      = { 0 };
+    long iterations[ MAXFACTORIES + 1 ] = { 0 };
+    int  completed[ MAXFACTORIES + 1 ]  = { 0 };
+    long long latency_sum = 0;
+    long      messages    = 0;
+
+    int  factories = 0, order = 0, made = 0, reclaimed = -1;
+    long long first = 0, last = 0;
+    int  done = 0;
+
+    char line[ LINE_MAX_LEN ], ev[32];
+
+    while ( ! done ) {
+
+        long at = ftell( in );
+
+        if ( fgets( line, sizeof(line), in ) == NULL || strchr( line, '\n' ) == NULL ) {
+
+            // end of what has been written so far
+            if ( ! follow ) {
+                break;
+            }
+
+            // a partial line is read again once it is complete
+            clearerr( in );
+            fseek( in, at, SEEK_SET );
+            Usleep( FOLLOW_POLL_MSEC * 1000 );
+            continue;
+        }
+
+        if ( ! recType( line, ev, sizeof(ev) ) ) {
+            continue;
+        }
+
+        long long t = recField( line, "t", 0 );
+        int fac     = (int) recField( line, "fac", 0 );
+
+        if ( first == 0 ) {
+            first = t;
+        }
+        last = t;
+
+        if ( fac < 0 || fac > MAXFACTORIES ) {
+            fac = 0;
+        }
+
+        if ( strcmp( ev, "start" ) == 0 ) {
+            factories = (int) recField( line, "factories", 0 );
+            order     = (int) recField( line, "order", 0 );
+
+        } else if ( strcmp( ev, "production" ) == 0 ) {
+            int p = (int) recField( line, "parts", 0 );
+            parts[fac] += p;
+            iterations[fac] += recField( line, "iterations", 1 );
+            made += p;
+            latency_sum += recField( line, "latency_ns", 0 );
+            messages ++;
+
+            if ( follow ) {
+                printf( "%8.3fs  Factory # %2d produced %4d parts   made %6d of %6d\n",
+                    ( t - first ) / 1e9, fac, p, made, order );
+            }
+
+        } else if ( strcmp( ev, "completion" ) == 0 ) {
+            completed[fac] = 1;
+
+            if ( follow ) {
+                printf( "%8.3fs  Factory # %2d completed\n", ( t - first ) / 1e9, fac );
+            }
+
+        } else if ( strcmp( ev, "factory" ) == 0 ) {
+            // final totals win over what was summed from the messages,
+            // they include progress from before a resumed order restarted
+            parts[fac]      = recField( line, "parts", parts[fac] );
+            iterations[fac] = recField( line, "iterations", iterations[fac] );
+
+        } else if ( strcmp( ev, "summary" ) == 0 ) {
+            made      = (int) recField( line, "made", made );
+            reclaimed = (int) recField( line, "reclaimed", 0 );
+            done      = 1;
+        }
+
+        if ( follow ) {
+            fflush( stdout );
+        }
+    }
+
+    fclose( in );
+
+
+    // summary
+    printf( "\n****** REPORT: %s ******\n", path );
+
+    for ( int i = 1; i < factories + 1 && i < MAXFACTORIES + 1; i ++ ) {
+        printf( "Factory # %2d made a total of %4ld parts in %5ld iterations%s\n",
+            i, parts[i], iterations[i], completed[i] ? "" : "   (not completed)" );
+    }
+
+    printf( "==============================\n" );
+    printf( "Parts made = %5d   vs  order size of %5d%s\n", made, order, done ? "" : "   (order still running)" );
+
+    if ( reclaimed >= 0 ) {
+        printf( "Parts reclaimed from lost claims = %5d\n", reclaimed );
+    }
+
+    if ( last > first ) {
+        printf( "Throughput = %.1f parts/sec over %.3f sec\n", made / ( ( last - first ) / 1e9 ), ( last - first ) / 1e9 );
+    }
+
+    if ( messages > 0 ) {
+        printf( "Average receive latency = %.1f usec over %ld messages\n", latency_sum / 1000.0 / messages, messages );
+    }
+
+    return 0;
+}
@@ -10,6 +10,9 @@ File Name   :   sales.c
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
 #include <signal.h>
 #include <time.h>
 #include <sys/types.h>
@@ -17,30 +20,101 @@ File Name   :   sales.c
 
 #include "wrappers.h"
 #include "shmem.h"
-
-#define LOG_MUTEX_NAME
-#define MEM_MUTEX_NAME
-#define FAC_DONE_SEM_NAME
-#define PRINT_REPORT_SEM_NAME
+#include "message.h"
+#include "logseg.h"
+#include "lease.h"
+#include "queue.h"
+#include "checkpoint.h"
+#include "latency.h"
+#include "sales.h"
+#include "autotune.h"
+#include "admission.h"
+#include "fleet.h"
+#ifdef FIXED_FLEET
+#include "bench.h"
+#endif
+
+#define MEM_MUTEX_NAME          "/leachjr_mem_mutex"
+#define FAC_DONE_SEM_NAME       "/leachjr_factories_done"
+#define PRINT_REPORT_SEM_NAME   "/leachjr_print_report"
+
+// how many times a factory that dies is restarted before sales gives up on it
+#define MAX_RESTARTS    3
 
 void cleanup();
 void sigHandle(int);
+void say(const char*, ...);
+void  fleetChild();
+pid_t spawnFactory(int);
+pid_t spawnStage(int, int);
+int   reapStage(pid_t, int);
+void  reportFor(int, int, int, int);
+int   parseStages(char*);
 
 // Global variables required for cleanup
-sem_t *factory_mutex, *shm_mutex, *factories_done, *print_report;
+sem_t *shm_mutex, *factories_done, *print_report;
 int mail_id, mem_id;
 shData *data;
 
+// Factory specs, kept so a factory that dies can be restarted as it was.
+// Indexed by factory ID, index 0 unused.
+int   capacities[ MAXFACTORIES + 1 ];
+int   durations[ MAXFACTORIES + 1 ];
+int   claim_sizes[ MAXFACTORIES + 1 ];
+pid_t factory_pids[ MAXFACTORIES + 1 ];
+int   restarts[ MAXFACTORIES + 1 ];
+
+// Production pipeline after fabrication, from -p. Indexed by stage, index 0 unused.
+int   num_stages = 0;
+char  stage_names[ MAXSTAGES + 1 ][ STAGE_NAME_LEN ];
+int   stage_workers[ MAXSTAGES + 1 ];
+int   stage_msec[ MAXSTAGES + 1 ];
+pid_t stage_pids[ MAXSTAGES + 1 ][ MAXSTAGEWORKERS ];
+int   stage_restarts[ MAXSTAGES + 1 ][ MAXSTAGEWORKERS ];
+int   stage_ended[ MAXSTAGES + 1 ];     // production was ended for the stage after it
+int   stages_running = 0;   // workers that have not finished yet
+
+// the order open between orderOpen() and orderClose()
+pid_t     supervisor_pid    = 0;
+int       factories_running = 0;    // factories that have not finished yet
+long long order_started     = 0;    // monotonicNanos() when the factories were created
+
+// when set, runOrder() does not narrate its progress
+int   quiet = 0;
+
+// Checkpoint file from -c, and the parts it says were already made
+char *checkpoint_path = NULL;
+int   resume_made = 0;
+
+// record IPC latency histograms, from -l
+int   latency_on = 0;
+
+// the binaries runOrder() runs. A fixed plant build benchmarks both kinds.
+const char *factory_bin    = FACTORY_BIN;
+const char *supervisor_bin = SUPERVISOR_BIN;
+
 void cleanup() {
+
+    // nothing to clean up before orderOpen() or after orderClose()
+    if ( data == NULL ) {
+        return;
+    }
+
+    for ( int i = 1; i < data -> num_stages + 1; i ++ ) {
+        queueDestroy( &data -> queues[i] );
+    }
+
     Shmdt( data );
+    data = NULL;
     shmctl( mem_id, IPC_RMID, NULL );
 
     msgctl( mail_id, IPC_RMID, NULL );
 
-    Sem_close( factory_mutex );  Sem_unlink( LOG_MUTEX_NAME );
     Sem_close( shm_mutex );      Sem_unlink( MEM_MUTEX_NAME );
     Sem_close( factories_done ); Sem_unlink( FAC_DONE_SEM_NAME );
     Sem_close( print_report );   Sem_unlink( PRINT_REPORT_SEM_NAME );
+
+    latDestroy();
 }
 
 void sigHandle (int sig) {
@@ -48,29 +122,270 @@ void sigHandle (int sig) {
     kill( 0, SIGKILL );
 }
 
-int main (int argc, char** argv) {
+// printf, unless sales was asked to be quiet
+void say (const char *fmt, ...) {
 
-    // Validate command lines arguments
+    va_list args;
 
-    if ( argc < 3 ) {
-        printf( "there must be at least 2 command lines arguments\n" );
-        exit( -1 );
+    if ( quiet ) {
+        return;
     }
-    
-    int n    = strtol( argv[1], NULL, 10 );
-    int size = strtol( argv[2], NULL, 10 );
 
-    if (n > 40) {
-        printf( "there may not be more than 40 factories.\n" );
+    va_start( args, fmt );
+    vprintf( fmt, args );
+    va_end( args );
+}
+
+// Called in a child of sales between fork and exec. A resident fleet shares
+// the daemon's terminal, but only the daemon may end it, so a Ctrl-C there
+// must not reach the factories, stages and supervisor. An ignored signal
+// stays ignored across exec.
+void fleetChild() {
+
+    if ( data -> resident ) {
+        sigactionWrapper( SIGINT, SIG_IGN );
+    }
+}
+
+// Forks and execs factory 'id' with its recorded capacity, duration and claim size.
+pid_t spawnFactory (int id) {
+
+    // big enough for any int, so a large capacity or duration is not cut short
+    char id_s[12], capacity_s[12], duration_s[12], claim_s[12];
+
+    // puts command line arguments into string buffers
+    snprintf( id_s,       sizeof(id_s),       "%d", id );
+    snprintf( capacity_s, sizeof(capacity_s), "%d", capacities[id] );
+    snprintf( duration_s, sizeof(duration_s), "%d", durations[id] );
+    snprintf( claim_s,    sizeof(claim_s),    "%d", claim_sizes[id] );
+
+    pid_t pid = Fork();
+
+    if ( pid == 0 ) {
+        fleetChild();
+        if ( execlp( factory_bin, "factory", id_s, capacity_s, duration_s, claim_s, (char*) NULL ) == -1 ) {
+            perror("factory exec failed");
+            exit( -1 );
+        }
+    }
+
+    return pid;
+}
+
+// Sets the specs of factories 1..n. A fixed plant build has its fleet
+// compiled in, and only runs orders on exactly that fleet.
+void drawSpecs (int n) {
+
+#ifdef FIXED_FLEET
+    static const int fleet_capacities[ FLEET_SIZE + 1 ] = FLEET_CAPACITY_TABLE;
+    static const int fleet_durations[ FLEET_SIZE + 1 ]  = FLEET_DURATION_TABLE;
+
+    if ( n != FLEET_SIZE ) {
+        printf( "this build runs exactly %d factories\n", FLEET_SIZE );
         exit( -1 );
     }
 
-    printf( "SALES: Will Request an Order of Size = %d parts\n", size );
+    for ( int i = 1; i < n+1; i ++ ) {
+        capacities[i]  = fleet_capacities[i];
+        durations[i]   = fleet_durations[i];
+        claim_sizes[i] = capacities[i];
+    }
+#else
+    for ( int i = 1; i < n+1; i ++ ) {
+
+        // IMPORTANT: modulus operands are 41 and 701, because the range must be inclusive.
+        capacities[i]  = random() % 41  + 10;
+        durations[i]   = random() % 701 + 500;
+        claim_sizes[i] = capacities[i];
+    }
+#endif
+}
 
+// Sends a message to the supervisor on behalf of factory 'id', which can no
+// longer send it itself.
+void reportFor (int id, int purpose, int parts, int batches) {
+
+    msgBuf message;
+    memset( &message, 0, sizeof(message) );
+    message.mtype     = 1;
+    message.purpose   = purpose;
+    message.facID     = id;
+    message.capacity  = capacities[id];
+    message.duration  = durations[id];
+    message.partsMade = parts;
+    message.batches   = batches;
+    message.sentAt    = monotonicNanos();
+
+    if ( msgsnd( mail_id, &message, MSG_INFO_SIZE, 0 ) == -1 ) {
+        perror( "sales.c, message on behalf of a factory failed to send" );
+    }
+}
 
-    // Signal handling
-    sigactionWrapper( SIGINT, sigHandle );
-    sigactionWrapper( SIGTERM, sigHandle );
+// Forks and execs worker 'w' of pipeline stage 's'.
+pid_t spawnStage (int s, int w) {
+
+    char stage_s[3], worker_s[3];
+
+    snprintf( stage_s,  3, "%d", s );
+    snprintf( worker_s, 3, "%d", w );
+
+    pid_t pid = Fork();
+
+    if ( pid == 0 ) {
+        fleetChild();
+        if ( execlp( "./stage", "stage", stage_s, worker_s, (char*) NULL ) == -1 ) {
+            perror("stage exec failed");
+            exit( -1 );
+        }
+    }
+
+    return pid;
+}
+
+// Ends production for the stage after stage 's' once all of the workers of
+// 's' are done, as far as it has not been ended already.
+void endStage (int s) {
+
+    stageQueue *in = &data -> queues[s];
+
+    Sem_wait( &in -> mutex );
+    int remaining = data -> stages[s].active;
+    Sem_post( &in -> mutex );
+
+    if ( remaining > 0 || stage_ended[s] ) {
+        return;
+    }
+    stage_ended[s] = 1;
+
+    if ( s == num_stages ) {
+        // a retired worker never got to mark the end of the pipeline
+        if ( data -> pipeline_end == 0 ) {
+            data -> pipeline_end = monotonicNanos();
+        }
+    } else {
+        stageItem done = { 0, 0 };
+        for ( int i = 0; i < stage_workers[s + 1]; i ++ ) {
+            queuePut( &data -> queues[s + 1], done );
+        }
+    }
+}
+
+// Handles the exit of process 'pid', if it is a pipeline worker. Returns 0 if
+// it is not. A worker that dies would never take its end marker, and the
+// stages after it would wait forever, so it is restarted. One that keeps
+// dying is retired while others remain, and its share of the end of
+// production is accounted for in its place.
+int reapStage (pid_t pid, int wstatus) {
+
+    int s = 0, w = 0;
+
+    for ( int i = 1; i < num_stages + 1 && s == 0; i ++ ) {
+        for ( int j = 0; j < stage_workers[i]; j ++ ) {
+            if ( stage_pids[i][j] == pid ) {
+                s = i;
+                w = j;
+            }
+        }
+    }
+
+    if ( s == 0 ) {
+        return 0;
+    }
+
+    stageInfo  *stage = &data -> stages[s];
+    stageQueue *in    = &data -> queues[s];
+
+    Sem_wait( &in -> mutex );
+    int ended = stage -> ended[w];
+    Sem_post( &in -> mutex );
+
+    // it got as far as leaving the stage, whether it exited cleanly or not
+    if ( ended == WORKER_DONE ) {
+        stage_pids[s][w] = 0;
+        stages_running --;
+        endStage( s );
+        return 1;
+    }
+
+    // the last worker of a stage is always restarted while production may
+    // still come its way. A stage without any would block whoever feeds it
+    // once its queue is full. Past its end marker nothing more can come.
+    int others = 0;
+    for ( int j = 0; j < stage_workers[s]; j ++ ) {
+        if ( j != w && stage_pids[s][j] != 0 ) {
+            others ++;
+        }
+    }
+
+    if ( stage_restarts[s][w] < MAX_RESTARTS || ( others == 0 && ended == WORKER_BUSY ) ) {
+        stage_restarts[s][w] ++;
+
+        Sem_wait( &in -> mutex );
+        stage -> ended[w] = WORKER_BUSY;
+        Sem_post( &in -> mutex );
+
+        stage_pids[s][w] = spawnStage( s, w );
+
+        // it died holding its end marker, so its replacement needs another
+        if ( ended == WORKER_ENDING ) {
+            stageItem done = { 0, 0 };
+            queuePut( in, done );
+        }
+
+        say( "SALES: Stage %d (%s) worker died and was restarted (%d)\n",
+            s, stage_names[s], stage_restarts[s][w] );
+        return 1;
+    }
+
+    // give up on it, and leave the stage in its place. A marker it did not
+    // take stays in the queue unused.
+    Sem_wait( &in -> mutex );
+    stage -> active --;
+    stage -> ended[w] = WORKER_DONE;
+    Sem_post( &in -> mutex );
+
+    stage_pids[s][w] = 0;
+    stages_running --;
+    say( "SALES: Stage %d (%s) worker failed too often and was retired\n", s, stage_names[s] );
+
+    endStage( s );
+
+    return 1;
+}
+
+// Parses a pipeline spec of the form name:workers:msec_per_part[,...]
+// into the stage_ arrays. Returns 0 if the spec is malformed.
+int parseStages (char *spec) {
+
+    num_stages = 0;
+
+    for ( char *tok = strtok( spec, "," ); tok != NULL; tok = strtok( NULL, "," ) ) {
+
+        int s = num_stages + 1;
+
+        if ( s > MAXSTAGES ) {
+            return 0;
+        }
+
+        if ( sscanf( tok, "%15[^:]:%d:%d", stage_names[s], &stage_workers[s], &stage_msec[s] ) != 3
+             || stage_workers[s] < 1 || stage_workers[s] > MAXSTAGEWORKERS || stage_msec[s] < 0 || stage_msec[s] > STAGE_MSEC_MAX ) {
+            return 0;
+        }
+
+        num_stages ++;
+    }
+
+    return num_stages > 0;
+}
+
+// Opens an order of 'size' parts on factories 1..n, whose specs must already
+// be in capacities[], durations[] and claim_sizes[]: sets up IPC and starts the
+// factories, the pipeline stages and the supervisor.
+// With 'done_fd' other than -1 the fleet is resident, see shmem.h. The
+// supervisor then writes its batch done notices to 'done_fd'.
+void orderOpen (int n, int size, int policy, int time_scale, int done_fd) {
+
+    say( "SALES: Will Request an Order of Size = %d parts\n", size );
 
 
     // IPC initialization
@@ -83,12 +398,44 @@ int main (int argc, char** argv) {
     key_t mem_key  = ftok( "shmem.h",   0 );
     mem_id  = Shmget( mem_key, SHMEM_SIZE, IPC_CREAT | IPC_EXCL | S_IRUSR | S_IWUSR );
     data = (shData*) Shmat( mem_id, NULL, 0 );
-    data -> order_size = size;
-    data -> made       = 0;
-    data -> remain     = size;
+    memset( data, 0, SHMEM_SIZE );
+    data -> order_size   = size;
+    data -> made         = resume_made;
+    data -> remain       = size - resume_made;
+    data -> fleet_size   = n;
+    data -> claim_policy = policy;
+    data -> time_scale   = time_scale;
+
+    if ( done_fd != -1 ) {
+        data -> resident = 1;
+        Sem_init( &data -> work, 1, 0 );
+    }
+
+    // latency histograms
+    if ( latency_on ) {
+        latCreate();
+        data -> latency  = 1;
+    }
+
+    // pipeline. Stage 0 is the factories themselves.
+    data -> num_stages   = num_stages;
+    snprintf( data -> stages[0].name, STAGE_NAME_LEN, "fabricate" );
+    data -> stages[0].workers = n;
+
+    for ( int i = 1; i < num_stages + 1; i ++ ) {
+        snprintf( data -> stages[i].name, STAGE_NAME_LEN, "%s", stage_names[i] );
+        data -> stages[i].workers       = stage_workers[i];
+        data -> stages[i].msec_per_part = stage_msec[i];
+        data -> stages[i].active        = stage_workers[i];
+        queueInit( &data -> queues[i] );
+    }
+
+    // report credits
+    for ( int i = 1; i < n + 1; i ++ ) {
+        data -> flow[i].credits = REPORT_CREDITS;
+    }
 
-    // mutex semaphores
-    factory_mutex  = Sem_open( LOG_MUTEX_NAME, O_CREAT | O_EXCL, S_IRUSR | S_IWUSR, 1 );
+    // mutex semaphore
     shm_mutex      = Sem_open( MEM_MUTEX_NAME, O_CREAT | O_EXCL, S_IRUSR | S_IWUSR, 1 );
 
     // rendezvous semaphores
@@ -96,84 +443,446 @@ int main (int argc, char** argv) {
     print_report   = Sem_open( PRINT_REPORT_SEM_NAME,   O_CREAT | O_EXCL, S_IRUSR | S_IWUSR, 0 );
 
 
-    // prepare to make factories
+    // prepare to make factories. The clock for the makespan starts here.
+    order_started = monotonicNanos();
+    data -> pipeline_start = order_started;
 
-    printf( "Creating %d Factory(ies)\n", n );
-
-    int factory_fd = open( "factory.log", O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR );
-
-    srandom( time(NULL) );
+    say( "Creating %d Factory(ies)\n", n );
 
+    // factories append to their log segments, so clear any left from an earlier run
+    segRemove( n );
 
     // makes factories.
     // IMPORTANT: i starts at 1 because factory id's start at 1.
     for ( int i = 1; i < n+1; i ++ ) {
 
-        char id[3], capacity[3], duration[5];
+        restarts[i]     = 0;
+        factory_pids[i] = spawnFactory( i );
 
-        // puts command line arguments into string buffers
-        // IMPORTANT: modulus operands are 41 and 701, because the range must be inclusive.
-        snprintf( id,       3, "%d",  i );
-        snprintf( capacity, 3, "%ld", random() % 41  + 10 );
-        snprintf( duration, 5, "%ld", random() % 701 + 500);
+        say( 
+            "SALES: Factory #%3d was created, with Capacity=%4d and Duration=%4d\n",
+            i, capacities[i], durations[i]
+        );
 
-        if ( Fork() == 0 ) {
-            // redirect stdout to mutex protected factory.log
-            dup2( factory_fd, STDOUT_FILENO );
+    }
 
-            if ( execlp( "./factory", "factory", id, capacity, duration, (char*) NULL ) == -1 ) {
-                perror("factory exec failed");
-                return -1;
-            }
-        }
 
-        printf( 
-            "SALES: Factory #%3s was created, with Capacity=%4s and Duration=%4s\n",
-            id, capacity, duration
-        );
+    // make the workers of the pipeline stages
+    for ( int i = 1; i < num_stages + 1; i ++ ) {
+        stage_ended[i] = 0;
+
+        for ( int w = 0; w < stage_workers[i]; w ++ ) {
+            stage_restarts[i][w] = 0;
+            stage_pids[i][w]     = spawnStage( i, w );
+            stages_running ++;
+        }
 
+        say( "SALES: Stage %d (%s) was created, with %d worker(s) at %d milliSecs per part\n",
+            i, stage_names[i], stage_workers[i], stage_msec[i] );
     }
 
 
     // make supervisor process
 
-    if ( Fork() == 0 ) {
+    supervisor_pid = Fork();
+
+    if ( supervisor_pid == 0 ) {
+
+        fleetChild();
         
         // redirect stdout to supervisor.log
-        int supervisor_fd = open( "supervisor.log", O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR );
+        int supervisor_fd = open( "supervisor.log", O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR );
         dup2( supervisor_fd, STDOUT_FILENO );
 
+        // batch done notices, on the descriptor the supervisor expects them on
+        if ( done_fd == BATCH_DONE_FD ) {
+            fcntl( done_fd, F_SETFD, 0 );
+        } else if ( done_fd != -1 ) {
+            dup2( done_fd, BATCH_DONE_FD );
+        }
+
         // put parameter in a string buffer
         char numlines[3];
         snprintf( numlines, 3, "%d", n );
 
-        if ( execlp( "./supervisor", "supervisor", numlines, (char*) NULL ) == -1 ) {
+        // the checkpoint path, if any, is passed on as a second argument
+        if ( execlp( supervisor_bin, "supervisor", numlines, checkpoint_path, (char*) NULL ) == -1 ) {
             perror("exec supervisor failed");
-            return -1;
+            exit( -1 );
         }
     }
 
+    factories_running = n;
+}
 
-    // Waits on semaphore from supervisor to indicate production is done
-    // Posts semaphore to tell supervisor to print report
-    Sem_wait( factories_done );
-    printf( "SALES: Supervisor says all Factories have completed their mission\n" );
+// Handles the exit of child 'pid' of an open order of n factories. A factory
+// that dies holding a claim would stall the order, so its claim goes back to
+// the pool and it is restarted.
+void orderReap (int n, pid_t pid, int wstatus) {
+
+    if ( pid == supervisor_pid ) {
+        fprintf( stderr, "SALES: Supervisor exited before the order was complete\n" );
+        supervisor_pid = 0;
+        return;
+    }
+
+    if ( reapStage( pid, wstatus ) ) {
+        return;
+    }
 
-    printf( "SALES: Permission granted to print final report\n" );
-    Sem_post( print_report );
+    int id = 0;
+    for ( int i = 1; i < n + 1; i ++ ) {
+        if ( factory_pids[i] == pid ) {
+            id = i;
+        }
+    }
 
+    if ( id == 0 ) {
+        return;
+    }
+
+    if ( WIFEXITED( wstatus ) && WEXITSTATUS( wstatus ) == 0 ) {
+        factories_running --;
+        return;
+    }
+
+    // take back its claim, and whatever it made but had not reported yet.
+    // Its reports still in the queue each hand a credit back, so the credits
+    // carry over, less the one for the report sent on its behalf.
+    Sem_wait( shm_mutex );
+    int parts     = leaseReclaim( data, id );
+    int completed = data -> completed[id];
+
+    flowControl *flow = &data -> flow[id];
+    int unreported    = flow -> pending_parts;
+    int batches       = flow -> pending_batches;
+    flow -> pending_parts   = 0;
+    flow -> pending_batches = 0;
+    if ( batches > 0 ) {
+        flow -> credits --;
+    }
+    Sem_post( shm_mutex );
+
+    say( "SALES: Factory #%3d died, returned %d claimed parts to the pool\n", id, parts );
+
+    // report what it made for it
+    if ( batches > 0 ) {
+        reportFor( id, PRODUCTION_MSG, unreported, batches );
+        say( "SALES: Factory #%3d had %d parts unreported, reported them for it\n", id, unreported );
+    }
+
+    // it died on its way out. The supervisor already counted it as done.
+    if ( completed ) {
+        factories_running --;
+        return;
+    }
+
+    if ( restarts[id] < MAX_RESTARTS ) {
+        restarts[id] ++;
+        factory_pids[id] = spawnFactory( id );
+        say( "SALES: Factory #%3d was restarted (%d of %d)\n", id, restarts[id], MAX_RESTARTS );
+    } else {
+        // give up on it, and tell the supervisor not to wait for it
+        reportFor( id, COMPLETION_MSG, 0, 0 );
+
+        say( "SALES: Factory #%3d failed too often and was retired\n", id );
+        factories_running --;
+    }
+}
+
+// Adds a batch of 'parts' to the open order of a resident fleet of n factories,
+// and wakes the idle ones. Returns the order size the batch is done at.
+int orderExtend (int n, int parts) {
+
+    Sem_wait( shm_mutex );
+    data -> order_size += parts;
+    data -> remain     += parts;
+    int target = data -> order_size;
+    Sem_post( shm_mutex );
+
+    for ( int i = 0; i < n; i ++ ) {
+        Sem_post( &data -> work );
+    }
+
+    return target;
+}
+
+// Tells the resident fleet of n factories to finish. With 'cancel' set the
+// parts not claimed yet are taken off the order instead of being made.
+void orderWindDown (int n, int cancel) {
+
+    Sem_wait( shm_mutex );
+    if ( cancel ) {
+        data -> order_size -= data -> remain;
+        data -> remain      = 0;
+    }
+    data -> closing = 1;
+    Sem_post( shm_mutex );
+
+    for ( int i = 0; i < n; i ++ ) {
+        Sem_post( &data -> work );
+    }
+}
+
+// Waits for the factories of an open order of n factories to finish, drains
+// the pipeline, has the supervisor print its report and tears the order down.
+// Returns the makespan, the time from creating the factories until the last
+// one exited, in nanoseconds.
+long long orderClose (int n) {
 
-    // Wait on all children to be destroyed
     int wstatus = 0;
 
-    for ( int i = 0; i < n + 1; i ++ ) {
-        waitpid( -1, &wstatus, 0 );
+    while ( factories_running > 0 ) {
+
+        pid_t pid = waitpid( -1, &wstatus, 0 );
+
+        if ( pid == -1 ) {
+            if ( errno == EINTR ) {
+                continue;
+            }
+            err_sys( "sales.c, waitpid failed" );
+        }
+
+        orderReap( n, pid, wstatus );
+    }
+
+
+    // Fabrication is over. Tell the first stage, and let the pipeline drain.
+    if ( num_stages > 0 ) {
+
+        stageItem done = { 0, 0 };
+        for ( int w = 0; w < stage_workers[1]; w ++ ) {
+            queuePut( &data -> queues[1], done );
+        }
+
+        while ( stages_running > 0 ) {
+
+            pid_t pid = waitpid( -1, &wstatus, 0 );
+
+            if ( pid == -1 ) {
+                if ( errno == EINTR ) {
+                    continue;
+                }
+                err_sys( "sales.c, waitpid failed" );
+            }
+
+            orderReap( n, pid, wstatus );
+        }
+
+        say( "SALES: All pipeline stages have drained\n" );
+    }
+
+    long long makespan = monotonicNanos() - order_started;
+
+
+    // Waits on semaphore from supervisor to indicate production is done
+    // Posts semaphore to tell supervisor to print report
+    if ( supervisor_pid != 0 ) {
+        Sem_wait( factories_done );
+        say( "SALES: Supervisor says all Factories have completed their mission\n" );
+
+        say( "SALES: Permission granted to print final report\n" );
+        Sem_post( print_report );
+
+        waitpid( supervisor_pid, &wstatus, 0 );
+        supervisor_pid = 0;
+
+        // the order is done, nothing left to resume
+        if ( checkpoint_path != NULL && WIFEXITED( wstatus ) && WEXITSTATUS( wstatus ) == 0 ) {
+            unlink( checkpoint_path );
+        }
     }
 
 
+    // Merge the factories' log segments into factory.log
+    segMerge( n, "factory.log" );
+
+
     // Destroy IPC
 
-    printf( "SALES: Cleaning up after the Supervisor Factory Processes\n" );
+    say( "SALES: Cleaning up after the Supervisor Factory Processes\n" );
     
     cleanup();
+
+    return makespan;
+}
+
+// Runs one order of 'size' parts on factories 1..n, see orderOpen(), and
+// returns its makespan in nanoseconds.
+long long runOrder (int n, int size, int policy, int time_scale) {
+
+    orderOpen( n, size, policy, time_scale, -1 );
+
+    return orderClose( n );
+}
+
+int main (int argc, char** argv) {
+
+    // Signal handling
+    sigactionWrapper( SIGINT, sigHandle );
+    sigactionWrapper( SIGTERM, sigHandle );
+
+    srandom( time(NULL) );
+
+
+#ifdef FIXED_FLEET
+    // benchmark mode: sales_fixed -b <order size> [repeats]
+    if ( argc > 2 && strcmp( argv[1], "-b" ) == 0 ) {
+
+        int size       = strtol( argv[2], NULL, 10 );
+        int repeats    = argc > 3 ? strtol( argv[3], NULL, 10 ) : BENCH_REPEATS;
+
+        if ( size < 1 || repeats < 1 ) {
+            printf( "usage: sales_fixed -b <order size> [repeats]\n" );
+            exit( -1 );
+        }
+
+        bench( size, repeats );
+        return 0;
+    }
+
+    // autotuning varies the fleet, which this build cannot
+    if ( argc > 1 && strcmp( argv[1], "-t" ) == 0 ) {
+        printf( "autotuning needs the generic build, this one runs a fixed fleet\n" );
+        exit( -1 );
+    }
+#endif
+
+    // autotune mode: sales -t <factory budget> <order size> [time scale] [repeats]
+    if ( argc > 3 && strcmp( argv[1], "-t" ) == 0 ) {
+
+        int budget     = strtol( argv[2], NULL, 10 );
+        int size       = strtol( argv[3], NULL, 10 );
+        int time_scale = argc > 4 ? strtol( argv[4], NULL, 10 ) : AUTOTUNE_TIME_SCALE;
+        int repeats    = argc > 5 ? strtol( argv[5], NULL, 10 ) : AUTOTUNE_REPEATS;
+
+        if ( budget < 1 || budget > MAXFACTORIES || time_scale < 1 || repeats < 1 ) {
+            printf( "usage: sales -t <1..%d factories> <order size> [time scale] [repeats]\n",
+                MAXFACTORIES );
+            exit( -1 );
+        }
+
+        autotune( budget, size, time_scale, repeats );
+        return 0;
+    }
+
+
+    // admission mode: sales -d <socket> <factories> [time scale]
+    if ( argc > 3 && strcmp( argv[1], "-d" ) == 0 ) {
+
+        int n          = strtol( argv[3], NULL, 10 );
+        int time_scale = argc > 4 ? strtol( argv[4], NULL, 10 ) : 1;
+
+        if ( n < 1 || n > MAXFACTORIES || time_scale < 1 ) {
+            printf( "usage: sales -d <socket> <1..%d factories> [time scale]\n", MAXFACTORIES );
+            exit( -1 );
+        }
+
+        // one fleet serves every order
+        drawSpecs( n );
+
+        serveOrders( argv[2], n, time_scale );
+        return 0;
+    }
+
+
+    // options, before the positional arguments:
+    //   -p name:workers:msec_per_part[,...]    production pipeline after fabrication
+    //   -c <file>                              checkpoint the order in <file>, resume from it if it exists
+    //   -l                                     record IPC latency histograms
+    while ( argc > 2 && argv[1][0] == '-' ) {
+
+        if ( strcmp( argv[1], "-l" ) == 0 ) {
+            latency_on = 1;
+            argc -= 1;
+            argv += 1;
+            continue;
+        }
+
+        if ( strcmp( argv[1], "-p" ) == 0 ) {
+            if ( ! parseStages( argv[2] ) ) {
+                printf( "bad pipeline '%s': expected up to %d stages of name:workers:msec_per_part,"
+                        " with 1..%d workers and 0..%d msec per part each\n",
+                        argv[2], MAXSTAGES, MAXSTAGEWORKERS, STAGE_MSEC_MAX );
+                exit( -1 );
+            }
+        } else if ( strcmp( argv[1], "-c" ) == 0 ) {
+            checkpoint_path = argv[2];
+        } else {
+            printf( "unknown option '%s'\n", argv[1] );
+            exit( -1 );
+        }
+
+        argc -= 2;
+        argv += 2;
+    }
+
+
+    // Validate command lines arguments
+
+    if ( argc < 3 ) {
+        printf( "there must be at least 2 command lines arguments\n" );
+        exit( -1 );
+    }
+    
+    int n    = strtol( argv[1], NULL, 10 );
+    int size = strtol( argv[2], NULL, 10 );
+
+    if (n < 1 || n > MAXFACTORIES) {
+        printf( "there must be 1 to %d factories.\n", MAXFACTORIES );
+        exit( -1 );
+    }
+
+
+    // a valid checkpoint means an interrupted order. Resume it with the
+    // same fleet, whatever the command line says.
+    ckptFile *ck = NULL;
+    int resuming = 0;
+
+    if ( checkpoint_path != NULL ) {
+        ck = ckptOpen( checkpoint_path );
+
+        if ( ck -> magic == CKPT_MAGIC ) {
+            resuming    = 1;
+            n           = ck -> fleet_size;
+            size        = ck -> order_size;
+            resume_made = ck -> state[ ck -> current ].made;
+
+            for ( int i = 1; i < n+1; i ++ ) {
+                capacities[i]  = ck -> capacities[i];
+                durations[i]   = ck -> durations[i];
+                claim_sizes[i] = ck -> claim_sizes[i];
+            }
+
+            printf( "SALES: Resuming order of %d parts on %d factories from '%s', %d parts already made\n",
+                size, n, checkpoint_path, resume_made );
+
+            ckptClose( ck );
+            ck = NULL;
+        }
+    }
+
+
+    // draw the factory specs
+    if ( ! resuming ) {
+        drawSpecs( n );
+    }
+
+    // a new checkpoint records the order and the fleet it runs on
+    if ( ck != NULL ) {
+        memset( ck, 0, sizeof(ckptFile) );
+        ck -> order_size = size;
+        ck -> fleet_size = n;
+
+        for ( int i = 1; i < n+1; i ++ ) {
+            ck -> capacities[i]  = capacities[i];
+            ck -> durations[i]   = durations[i];
+            ck -> claim_sizes[i] = claim_sizes[i];
+        }
+
+        ck -> magic = CKPT_MAGIC;
+        ckptClose( ck );
+    }
+
+    runOrder( n, size, ORDER_POLICY, 1 );
 }
@@ -0,0 +1,37 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   sales.h
+----------------------------------------------------*/
+
+// What sales.c shares with the other parts of the sales program.
+// Include shmem.h first.
+
+// Factory specs, indexed by factory ID, index 0 unused
+extern int  capacities[ MAXFACTORIES + 1 ];
+extern int  durations[ MAXFACTORIES + 1 ];
+extern int  claim_sizes[ MAXFACTORIES + 1 ];
+
+// when set, runOrder() does not narrate its progress
+extern int  quiet;
+
+// the factory and supervisor binaries runOrder() runs
+extern const char *factory_bin;
+extern const char *supervisor_bin;
+
+void        drawSpecs( int n );
+long long   runOrder( int n, int size, int policy, int time_scale );
+
+// runOrder() in phases, for a fleet that stays resident across orders
+extern pid_t supervisor_pid;        // 0 once the supervisor has exited
+extern int   factories_running;
+void        orderOpen( int n, int size, int policy, int time_scale, int done_fd );
+void        orderReap( int n, pid_t pid, int wstatus );
+int         orderExtend( int n, int parts );
+void        orderWindDown( int n, int cancel );
+long long   orderClose( int n );
+
+// cleans up the order's IPC and kills the process group
+void        sigHandle( int sig );
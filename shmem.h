@@ -5,6 +5,93 @@
 //---------------------------------------------------------------------
 
 #include <semaphore.h>
+#include <sys/types.h>
+
+#define MAXFACTORIES    40
+
+// A claim of parts by one factory. While the factory is making them the parts
+// are neither 'made' nor 'remain'. If the owner dies, or does not finish by
+// the deadline, the parts go back to 'remain' (see lease.h).
+typedef struct
+{
+    pid_t       owner ;     // factory process holding the claim, 0 if none
+    int         parts ;     // #parts claimed
+    long long   deadline ;  // monotonicNanos() after which the claim may be taken back
+} claimLease ;
+
+#define MAXSTAGES           4       // pipeline stages after fabrication
+#define MAXSTAGEWORKERS     8       // worker processes per stage
+#define STAGE_QUEUE_CAP     16      // batches an inter-stage queue holds
+#define STAGE_NAME_LEN      16
+#define STAGE_MSEC_MAX      1000    // longest time a stage may take per part
+
+// How far a pipeline worker has got with the end of production
+#define WORKER_BUSY         0       // has not taken its end marker
+#define WORKER_ENDING       1       // took its end marker, still counted in 'active'
+#define WORKER_DONE         2       // no longer counted in 'active'
+
+// A batch of parts travelling down the production pipeline
+typedef struct
+{
+    int     parts ;         // #parts in the batch. 0 marks the end of production
+    int     facID ;         // factory that made it
+} stageItem ;
+
+// Bounded queue in front of a pipeline stage. A full queue blocks whoever
+// feeds it, so a slow stage pushes back on the stages before it.
+typedef struct
+{
+    sem_t       slots ;     // free slots
+    sem_t       items ;     // queued batches
+    sem_t       mutex ;
+    int         head , tail , count ;
+    stageItem   ring[ STAGE_QUEUE_CAP ] ;
+
+    long        samples ;       // occupancy is sampled at every put
+    long        occupancy_sum ;
+    int         occupancy_max ;
+} stageQueue ;
+
+// One stage of the pipeline and its statistics
+typedef struct
+{
+    char        name[ STAGE_NAME_LEN ] ;
+    int         workers ;
+    int         msec_per_part ;
+    int         active ;        // workers still running, under the input queue's mutex
+    char        ended[ MAXSTAGEWORKERS ] ;  // WORKER_ state of each worker, likewise
+    long        batches ;
+    long        parts ;
+    long long   busy_ns ;       // summed over the workers
+    long long   blocked_ns ;    // time spent waiting for room in the next queue
+} stageInfo ;
+
+// Report credits. A factory may only send a production report while it
+// holds a credit. The supervisor hands a credit back for every report it
+// handles. Without one a factory keeps producing and folds its reports into
+// one aggregate, so a slow supervisor never stalls production.
+#define REPORT_CREDITS      4       // credits each factory starts with
+
+typedef struct
+{
+    int         credits ;       // credits the factory holds
+    long        stalls ;        // reports delayed for lack of a credit
+    long long   blocked_ns ;    // time spent blocked in msgsnd
+
+    // production made but not reported yet, so sales can report it for a
+    // factory that dies with it. A factory takes it off in the same critical
+    // section that takes the credit for its report, so the two can never
+    // both report it. If the factory dies before sending, the report is lost.
+    int         pending_parts ;
+    int         pending_batches ;
+} flowControl ;
+
+// How a factory sizes its claims
+typedef enum
+{
+    CLAIM_FIXED = 0 ,   // claim the factory's claim size each time
+    CLAIM_GUIDED        // claim an even share of what remains, at most the claim size
+} claimPolicy_t ;
 
 typedef struct 
 {
@@ -13,7 +100,35 @@ typedef struct
     int   remain ;      // #parts remaining to be manufactured
     // When a factory is in the middle of making 'x' parts, made+remain+x = order_size
     // So, it is not always true that made + remain = order_size
+    int   leased ;      // #parts currently held by leases, the sum of all 'x' above
+    int   reclaimed ;   // #parts taken back from dead or late factories
+    int   fleet_size ;  // #factories working on the order
+    int   claim_policy ;    // a claimPolicy_t
+    int   time_scale ;  // production durations are divided by this. 1 is real time
+    int   latency ;     // IPC latency histograms are being recorded, see latency.h
+
+    // Resident fleet, sales -d. The factories and the supervisor live across
+    // orders. Sales adds each batch to order_size and remain, and posts 'work'
+    // once per factory. Idle factories wait on it instead of exiting, until
+    // sales sets 'closing'.
+    int   resident ;
+    int   closing ;
+    sem_t work ;
+
+    // Production pipeline. Stage 0 is fabrication, done by the factories.
+    // queues[s] feeds stage s, for 1 <= s <= num_stages.
+    int         num_stages ;    // #stages after fabrication, 0 for none
+    long long   pipeline_start ;    // monotonicNanos() when production started
+    long long   pipeline_end ;      // ... and when the last stage finished
+    stageInfo   stages[ MAXSTAGES + 1 ] ;
+    stageQueue  queues[ MAXSTAGES + 1 ] ;
+    claimLease leases[ MAXFACTORIES + 1 ] ; // indexed by factory ID, index 0 unused
+    int   completed[ MAXFACTORIES + 1 ] ;    // factory sent its completion message, so it must not be restarted
+    flowControl flow[ MAXFACTORIES + 1 ] ;  // indexed by factory ID, index 0 unused
 } shData ;
 
 #define SHMEM_SIZE      sizeof(shData)
-#define MAXFACTORIES    20
+
+// The supervisor of a resident fleet writes order_size, as an int, to this
+// descriptor each time it has seen that many parts reported
+#define BATCH_DONE_FD   3
@@ -0,0 +1,97 @@
+/*----------------------------------------------------
+Assignment  :   PA2-IPC
+Date        :   03/25/2024
+Authors     :   Josiah Leach    leachjr@dukes.jmu.edu
+                Luke Hennessy   henneslk@dukes.jmu.edu
+File Name   :   stage.c
+----------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "wrappers.h"
+#include "shmem.h"
+#include "queue.h"
+
+
+int main (int argc, char** argv) {
+
+    if ( argc < 3 ) {
+        fprintf( stderr, "stage expected two command line arguments\n" );
+        exit( -1 );
+    }
+
+    // which pipeline stage this worker serves, and which of its workers it is
+    int s = strtol( argv[1], NULL, 10 );
+    int w = strtol( argv[2], NULL, 10 );
+
+
+    // access IPC
+
+    // shared memory
+    key_t key = ftok( "shmem.h", 0 );
+    int shm_id = Shmget( key, SHMEM_SIZE, S_IRUSR | S_IWUSR );
+    shData* data = (shData*) Shmat( shm_id, NULL, 0 );
+
+    if ( s < 1 || s > data -> num_stages || w < 0 || w >= data -> stages[s].workers ) {
+        fprintf( stderr, "stage %d worker %d is not configured\n", s, w );
+        exit( -1 );
+    }
+
+    stageInfo  *stage = &data -> stages[s];
+    stageQueue *in    = &data -> queues[s];
+
+    // the last stage has nowhere to pass its batches on to
+    int         last  = ( s == data -> num_stages );
+    stageQueue *out   = last ? NULL : &data -> queues[s + 1];
+
+    int time_scale = data -> time_scale > 0 ? data -> time_scale : 1;
+
+
+    // work until the end of production marker arrives
+    while ( 1 ) {
+
+        stageItem item = queueGet( in, &stage -> ended[w] );
+
+        if ( item.parts == 0 ) {
+            break;
+        }
+
+        long long start = monotonicNanos();
+        Usleep( (useconds_t) ( (long long) item.parts * stage -> msec_per_part * 1000 / time_scale ) );
+        long long busy = monotonicNanos() - start;
+
+        long long blocked = 0;
+        if ( ! last ) {
+            blocked = queuePut( out, item );
+        }
+
+        // the stage's statistics are guarded by its input queue's mutex
+        Sem_wait( &in -> mutex );
+        stage -> batches ++;
+        stage -> parts      += item.parts;
+        stage -> busy_ns    += busy;
+        stage -> blocked_ns += blocked;
+        Sem_post( &in -> mutex );
+    }
+
+
+    // Sales ends production for the next stage once every worker of this
+    // one is done, see reapStage(). The last worker out of the last stage
+    // marks the end of the pipeline.
+    Sem_wait( &in -> mutex );
+    int remaining = -- stage -> active;
+    stage -> ended[w] = WORKER_DONE;
+    Sem_post( &in -> mutex );
+
+    if ( remaining == 0 && last ) {
+        data -> pipeline_end = monotonicNanos();
+    }
+
+
+    // detach from IPC
+    Shmdt( data );
+}
@@ -13,14 +13,76 @@ File Name   :   supervisor.c
 #include <sys/shm.h>
 #include <sys/msg.h>
 #include <unistd.h>
+#include <errno.h>
+#include <sched.h>
 
 #include "wrappers.h"
 #include "shmem.h"
 #include "message.h"
+#include "checkpoint.h"
+#include "latency.h"
+#include "record.h"
+#include "fleet.h"
 
-#define MEM_MUTEX_NAME
-#define FAC_DONE_SEM_NAME
-#define PRINT_REPORT_SEM_NAME
+#define MEM_MUTEX_NAME          "/leachjr_mem_mutex"
+#define FAC_DONE_SEM_NAME       "/leachjr_factories_done"
+#define PRINT_REPORT_SEM_NAME   "/leachjr_print_report"
+
+// most messages handled per wakeup before going back to the queue
+#define DRAIN_MAX       64
+
+// bounds for the adaptive spin. The supervisor retries a non-blocking
+// receive up to spin_budget times before blocking in msgrcv.
+#define SPIN_MIN        16
+#define SPIN_MAX        4096
+
+// size of the stdout buffer. supervisor.log is written in chunks this big.
+#define LOG_BUFFER_SIZE (64 * 1024)
+
+
+// Prints throughput, utilization and queue occupancy for every pipeline
+// stage, and names the stage that limits the pipeline.
+// Called once the pipeline has drained, so no locking is needed.
+void printPipeline( shData *data ) {
+
+    double elapsed = ( data -> pipeline_end - data -> pipeline_start ) / 1e9;
+    int    bottleneck = 0;
+    double bottleneck_busy = -1;
+
+    printf( "\n****** SUPERVISOR: Pipeline Report ******\n" );
+    printf( "Stage            Workers  Parts  Parts/sec  Busy%%   Queue avg  max  Blocked ms\n" );
+
+    for ( int s = 0; s < data -> num_stages + 1; s ++ ) {
+
+        stageInfo  *stage = &data -> stages[s];
+        stageQueue *q     = &data -> queues[s];
+
+        // share of the stage's worker time spent working
+        double busy = elapsed > 0 ? 100.0 * stage -> busy_ns / 1e9 / ( stage -> workers * elapsed ) : 0;
+
+        if ( busy > bottleneck_busy ) {
+            bottleneck      = s;
+            bottleneck_busy = busy;
+        }
+
+        printf( "%-16s %7d %6ld %10.1f %5.1f%% ",
+            stage -> name, stage -> workers, stage -> parts,
+            elapsed > 0 ? stage -> parts / elapsed : 0, busy );
+
+        // fabrication has no queue in front of it
+        if ( s == 0 ) {
+            printf( "%11s %4s", "-", "-" );
+        } else {
+            printf( "%11.2f %4d",
+                q -> samples ? (double) q -> occupancy_sum / q -> samples : 0, q -> occupancy_max );
+        }
+
+        printf( " %11.1f\n", stage -> blocked_ns / 1e6 );
+    }
+
+    printf( "Bottleneck stage: %s (%.1f%% busy)\n",
+        data -> stages[bottleneck].name, bottleneck_busy );
+}
 
 
 int main( int argc, char** argv ) {
@@ -31,10 +93,23 @@ int main( int argc, char** argv ) {
         exit( -1 );
     }
 
+#ifdef FIXED_FLEET
+    const int numlines = FLEET_SIZE;
+
+    if ( strtol( argv[1], NULL, 10 ) != FLEET_SIZE ) {
+        fprintf( stderr, "supervisor: this build supervises %d factories, not %s\n", FLEET_SIZE, argv[1] );
+        exit( -1 );
+    }
+#else
     int numlines = strtol( argv[1], NULL, 10 );
+#endif
     int finished_lines = 0;
 
 
+    // stdout is supervisor.log, so fully buffer it and flush once per
+    // wakeup instead of paying a write() per line
+    setvbuf( stdout, NULL, _IOFBF, LOG_BUFFER_SIZE );
+
     printf( "\nSUPERVISOR: Started\n" );
 
 
@@ -42,14 +117,47 @@ int main( int argc, char** argv ) {
     // IMPORTANT: there is one more element in the arrays than there are factories
     // this is so that the id's, which count from one can be used to index the
     // arrays without modification. As a result, index 0 holds no data.
+#ifdef FIXED_FLEET
+    int parts_produced[ FLEET_SIZE + 1 ];
+    int iterations[ FLEET_SIZE + 1 ];
+#else
     int *parts_produced =  (int*)  malloc( sizeof(int) * (numlines + 1) );
     int *iterations     =  (int*)  malloc( sizeof(int) * (numlines + 1) );
+#endif
 
-    for ( int i = 1; i < numlines + 1; i ++ ) {
+    for ( int i = 0; i < numlines + 1; i ++ ) {
         parts_produced[i] = 0;
         iterations[i]     = 0;
     }
 
+    int reported_made = 0;
+
+
+    // optional second argument: checkpoint file of a resumable order.
+    // Pick up the totals it holds, and keep it current as messages arrive.
+    ckptFile *ck = NULL;
+
+    if ( argc > 2 ) {
+        ck = ckptOpen( argv[2] );
+
+        if ( ck -> magic != CKPT_MAGIC || ck -> fleet_size != numlines ) {
+            fprintf( stderr, "supervisor: '%s' is not a checkpoint for %d factories\n", argv[2], numlines );
+            exit( -1 );
+        }
+
+        ckptState *st = &ck -> state[ ck -> current ];
+
+        reported_made = st -> made;
+        for ( int i = 1; i < numlines + 1; i ++ ) {
+            parts_produced[i] = st -> parts_produced[i];
+            iterations[i]     = st -> iterations[i];
+        }
+
+        if ( reported_made > 0 ) {
+            printf( "SUPERVISOR: Resuming with %d parts already made\n", reported_made );
+        }
+    }
+
     
     // link to IPC
 
@@ -62,6 +170,10 @@ int main( int argc, char** argv ) {
     int mem_id = Shmget( mem_key, SHMEM_SIZE, 0 );
     shData* data = (shData*) Shmat( mem_id, NULL, 0 );
 
+    if ( data -> latency ) {
+        latAttach();
+    }
+
     // mutex semaphore
     sem_t* shm_mutex = Sem_open2( MEM_MUTEX_NAME, 0 );
 
@@ -70,37 +182,174 @@ int main( int argc, char** argv ) {
     sem_t *print_report   = Sem_open2( PRINT_REPORT_SEM_NAME, 0 );
 
 
+    // structured record stream, alongside the text log
+    FILE *rec = recOpen( REC_PATH );
+    recEvent( rec, "start", "\"factories\":%d,\"order\":%d", numlines, data -> order_size );
+    recFlush( rec );
+
+
     // variables for supervising loop
-    int reported_made = 0;
-    msgBuf message;
+    msgBuf batch[DRAIN_MAX];
+
+    // adaptive polling state and receive statistics
+    int       spin_budget     = SPIN_MIN;
+    long      wakeups         = 0;
+    long      spin_wakeups    = 0;
+    long      received        = 0;
+    int       max_batch       = 0;
+    long long latency_sum     = 0;
+    long long latency_max     = 0;
+
+    // flow control statistics. Indexed by factory ID, index 0 unused.
+    long      depth_sum       = 0;
+    int       depth_max       = 0;
+#ifdef FIXED_FLEET
+    long      delayed[ FLEET_SIZE + 1 ] = { 0 };
+    char      completed[ FLEET_SIZE + 1 ] = { 0 };
+#else
+    long     *delayed         = (long*) calloc( numlines + 1, sizeof(long) );
+    char     *completed       = (char*) calloc( numlines + 1, sizeof(char) );
+#endif
+    struct msqid_ds qstat;
+
+    // a resident fleet's order grows batch by batch. The largest order size
+    // whose parts have all been reported, and told sales about.
+    int signaled = 0;
 
     
     // while some factories are still working
     while ( finished_lines < numlines ) {
 
-        // wait to receive a message
-        if(msgrcv( mail_id, &message, MSG_INFO_SIZE, 0, 0 ) == -1) {
-            perror( "supervisor.c, message receive failed" );
+        int count = 0;
+
+        // spin on a non-blocking receive first. Under load a message is
+        // usually already there and we never go to sleep.
+        for ( int spin = 0; spin < spin_budget && count == 0; spin ++ ) {
+            if ( msgrcv( mail_id, &batch[0], MSG_INFO_SIZE, 0, IPC_NOWAIT ) != -1 ) {
+                count = 1;
+            } else if ( errno == ENOMSG ) {
+                sched_yield();
+            } else if ( errno != EINTR ) {
+                perror( "supervisor.c, message receive failed" );
+            }
+        }
+
+        if ( count > 0 ) {
+            // spinning paid off, allow more of it next time
+            spin_wakeups ++;
+            spin_budget = ( spin_budget * 2 > SPIN_MAX ) ? SPIN_MAX : spin_budget * 2;
+        } else {
+            // queue stayed empty, stop burning cpu and block
+            spin_budget = ( spin_budget / 2 < SPIN_MIN ) ? SPIN_MIN : spin_budget / 2;
+
+            if ( Msgrcv_lat( mail_id, &batch[0], MSG_INFO_SIZE, 0, 0, LAT_RECV ) == -1 ) {
+                if ( errno != EINTR ) {
+                    perror( "supervisor.c, message receive failed" );
+                }
+                continue;
+            }
+            count = 1;
         }
 
-        
-        if ( message.purpose == COMPLETION_MSG ) {
-            finished_lines++;
-            printf( 
-                "SUPERVISOR: Factory # %2d        COMPLETED its task\n",
-                message.facID
-            );
-        } else if ( message.purpose == PRODUCTION_MSG ) {
-            printf( 
-                "SUPERVISOR: Factory # %2d produced %4d parts in %4d milliseconds\n",
-                message.facID, message.partsMade, message.duration
-            );
-            
-            // update production statistics
-            parts_produced[message.facID] += message.partsMade;
-            iterations[message.facID] ++;
-            
-            reported_made += message.partsMade;
+        // sample the queue depth this wakeup found
+        if ( msgctl( mail_id, IPC_STAT, &qstat ) == 0 ) {
+            int depth = (int) qstat.msg_qnum + 1;
+            depth_sum += depth;
+            if ( depth > depth_max ) {
+                depth_max = depth;
+            }
+        }
+
+        // drain whatever else is already waiting
+        while ( count < DRAIN_MAX &&
+                msgrcv( mail_id, &batch[count], MSG_INFO_SIZE, 0, IPC_NOWAIT ) != -1 ) {
+            count ++;
+        }
+
+        long long now = monotonicNanos();
+
+        wakeups ++;
+        received += count;
+        if ( count > max_batch ) {
+            max_batch = count;
+        }
+
+
+        for ( int i = 0; i < count; i ++ ) {
+            msgBuf *message = &batch[i];
+
+            long long latency = now - message->sentAt;
+            latency_sum += latency;
+            if ( latency > latency_max ) {
+                latency_max = latency;
+            }
+
+            if ( message->purpose == COMPLETION_MSG ) {
+                // a factory restarted just after completing completes twice
+                if ( completed[message->facID] ) {
+                    continue;
+                }
+                completed[message->facID] = 1;
+                finished_lines++;
+                recEvent( rec, "completion", "\"fac\":%d", message->facID );
+                printf( 
+                    "SUPERVISOR: Factory # %2d        COMPLETED its task\n",
+                    message->facID
+                );
+            } else if ( message->purpose == PRODUCTION_MSG ) {
+                if ( message->batches > 1 ) {
+                    // the factory ran out of credits and folded several iterations
+                    printf( 
+                        "SUPERVISOR: Factory # %2d produced %4d parts in %4d iterations (delayed report)\n",
+                        message->facID, message->partsMade, message->batches
+                    );
+                    delayed[message->facID] ++;
+                } else {
+                    printf( 
+                        "SUPERVISOR: Factory # %2d produced %4d parts in %4d milliseconds\n",
+                        message->facID, message->partsMade, message->duration
+                    );
+                }
+                
+                // update production statistics
+                parts_produced[message->facID] += message->partsMade;
+                iterations[message->facID] += message->batches;
+                
+                reported_made += message->partsMade;
+
+                recEvent( rec, "production",
+                    "\"fac\":%d,\"parts\":%d,\"iterations\":%d,\"duration\":%d,\"latency_ns\":%lld",
+                    message->facID, message->partsMade, message->batches, message->duration, latency );
+            }
+        }
+
+        // hand a report credit back for every production report handled
+        Sem_wait( shm_mutex );
+        for ( int i = 0; i < count; i ++ ) {
+            if ( batch[i].purpose == PRODUCTION_MSG ) {
+                data -> flow[ batch[i].facID ].credits ++;
+            }
+        }
+        int target = data -> order_size;
+        Sem_post( shm_mutex );
+
+        // every batch added so far has been made
+        if ( data -> resident && target > signaled && reported_made >= target ) {
+            if ( write( BATCH_DONE_FD, &target, sizeof(target) ) != sizeof(target) ) {
+                perror( "supervisor.c, batch done notice failed" );
+            }
+            signaled = target;
+        }
+
+        recFlush( rec );
+
+        // sales may kill the process group at any time, so nothing may
+        // stay buffered past this wakeup
+        fflush( stdout );
+
+        // every message handled is an iteration boundary
+        if ( ck != NULL ) {
+            ckptCommit( ck, reported_made, numlines, parts_produced, iterations );
         }
 
     }
@@ -109,6 +358,7 @@ int main( int argc, char** argv ) {
     // inform sales that all factories are done
     Sem_post( factories_done );
     printf( "\nSUPERVISOR: Manufacturing is complete. Awaiting permission to print final report\n");
+    fflush( stdout );
 
 
     // wait for sales to give permission to print final report
@@ -118,6 +368,7 @@ int main( int argc, char** argv ) {
     // find out how many parts should have been made.
     Sem_wait(shm_mutex);
     int requested = data -> order_size;
+    int reclaimed = data -> reclaimed;
     Sem_post(shm_mutex);
 
 
@@ -130,6 +381,8 @@ int main( int argc, char** argv ) {
             "Factory # %2d made a total of %4d parts in %5d iterations\n",
             i, parts_produced[i], iterations[i]
         );
+        recEvent( rec, "factory", "\"fac\":%d,\"parts\":%d,\"iterations\":%d",
+            i, parts_produced[i], iterations[i] );
     }
 
     // print total parts made
@@ -138,6 +391,50 @@ int main( int argc, char** argv ) {
         "Grand total parts made = %5d   vs  order size of %5d\n",
         reported_made, requested
     );
+    printf( "Parts reclaimed from lost claims = %5d\n", reclaimed );
+
+    recEvent( rec, "summary", "\"made\":%d,\"order\":%d,\"reclaimed\":%d",
+        reported_made, requested, reclaimed );
+    recClose( rec );
+
+    // print receive statistics
+    printf( "\n****** SUPERVISOR: Receive Statistics ******\n" );
+    printf(
+        "Wakeups %6ld  (%ld after spinning, %ld after blocking)\n",
+        wakeups, spin_wakeups, wakeups - spin_wakeups
+    );
+    printf(
+        "Messages per wakeup: avg %6.2f  max %4d\n",
+        wakeups ? (double) received / wakeups : 0.0, max_batch
+    );
+    printf(
+        "Receive latency (usec): avg %9.1f  max %9.1f\n",
+        received ? latency_sum / 1000.0 / received : 0.0, latency_max / 1000.0
+    );
+
+    // print flow control statistics. Factories have exited, so no locking.
+    printf( "\n****** SUPERVISOR: Flow Control ******\n" );
+    printf(
+        "Queue depth at wakeup: avg %6.2f  max %4d\n",
+        wakeups ? (double) depth_sum / wakeups : 0.0, depth_max
+    );
+    for ( int i = 1; i < numlines + 1; i ++ ) {
+        printf(
+            "Factory # %2d: %4ld credit stalls, %4ld delayed reports, %9.1f ms blocked sending\n",
+            i, data -> flow[i].stalls, delayed[i], data -> flow[i].blocked_ns / 1e6
+        );
+    }
+
+    // print latency histograms
+    if ( data -> latency ) {
+        latReport();
+    }
+
+    // print pipeline statistics
+    if ( data -> num_stages > 0 ) {
+        printPipeline( data );
+    }
+
     printf( "\n>>> Supervisor Terminated\n" );
 
 
@@ -148,7 +445,15 @@ int main( int argc, char** argv ) {
     // detach shared memory
     Shmdt( data );
 
+    if ( ck != NULL ) {
+        ckptClose( ck );
+    }
+
     // free malloced memory
+#ifndef FIXED_FLEET
     free( parts_produced );
     free( iterations );
+    free( delayed );
+    free( completed );
+#endif
 }
@@ -11,6 +11,8 @@
 #include <string.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <sys/mman.h>
+#include <time.h>
 
 #include "wrappers.h"
 
@@ -83,6 +85,32 @@ int Usleep( useconds_t usec )
 
 //------------------------------------------------------------
 
+int  Clock_gettime( clockid_t clk, struct timespec *tp )
+{
+    int code ;
+
+    code = clock_gettime( clk , tp ) ;
+    if ( code != 0 )
+        err_sys( "clock_gettime failed" );
+
+    return code ;
+}
+
+//------------------------------------------------------------
+/* Nanoseconds on the system-wide monotonic clock. Comparable
+   across processes, so it can be used to timestamp IPC.      */
+
+long long monotonicNanos( void )
+{
+    struct timespec ts ;
+
+    Clock_gettime( CLOCK_MONOTONIC , &ts ) ;
+
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec ;
+}
+
+//------------------------------------------------------------
+
 int  Shmget( key_t key, size_t size, int shmflg )
 {
     int   shmid ;
@@ -130,6 +158,45 @@ int  Shmdt( const void *shmaddr )
 
 //------------------------------------------------------------
 
+void *Mmap( void *addr, size_t len, int prot, int flags, int fd, off_t offset )
+{
+    void *p ;
+
+    p = mmap( addr , len , prot , flags , fd , offset ) ;
+    if ( p == MAP_FAILED )
+        err_sys( "mmap failed" ) ;
+
+    return p ;
+}
+
+//------------------------------------------------------------
+
+int  Munmap( void *addr, size_t len )
+{
+    int code ;
+
+    code = munmap( addr , len ) ;
+    if ( code != 0 )
+        err_sys( "munmap failed" ) ;
+
+    return code ;
+}
+
+//------------------------------------------------------------
+
+int  Ftruncate( int fd, off_t len )
+{
+    int code ;
+
+    code = ftruncate( fd , len ) ;
+    if ( code != 0 )
+        err_sys( "ftruncate failed" ) ;
+
+    return code ;
+}
+
+//------------------------------------------------------------
+
 sem_t  *Sem_open( const char *name, int oflag, mode_t mode, unsigned int value )
 {
     sem_t  *s;
@@ -6,8 +6,10 @@
 #include <semaphore.h>
 #include <sys/types.h>
 #include <sys/msg.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <signal.h>
+#include <time.h>
 
 void    unix_error(char *msg) ;
 void    err_sys( const char* x ) ;
@@ -17,10 +19,17 @@ void    posix_error( int code, char *msg) ;
 pid_t   Fork( void );
 int     Usleep( useconds_t usec );
 
+int     Clock_gettime( clockid_t clk, struct timespec *tp ) ;
+long long monotonicNanos( void ) ;
+
 int     Shmget( key_t key, size_t size, int shmflg );
 void   *Shmat( int shmid, const void *shmaddr, int shmflg );
 int     Shmdt( const void *shmaddr ) ;
 
+void   *Mmap( void *addr, size_t len, int prot, int flags, int fd, off_t offset ) ;
+int     Munmap( void *addr, size_t len ) ;
+int     Ftruncate( int fd, off_t len ) ;
+
 sem_t  *Sem_open( const char *name, int oflag, mode_t mode, unsigned int value );
 sem_t  *Sem_open2( const char *name, int oflag ) ;
 int     Sem_close( sem_t *sem );